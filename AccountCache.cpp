@@ -0,0 +1,301 @@
+/*
+* Class AccountCache
+* ==================
+*
+* An in-memory cache of user name -> salted password hash, read through by
+* AccountManager::getPassword() (and so verifyPassword()), so that bursts of
+* logins for the same accounts are answered without touching SQLite.
+*
+* The cache is split into shards, each with its own lock, so concurrent
+* lookups of different users rarely wait on each other.  A shard is an LRU
+* list within a byte budget (maxBytes / shards; an entry costs its name, its
+* hash and ENTRY_OVERHEAD).  Admission is TinyLFU: every lookup, hit or miss,
+* is counted in a small count-min sketch of 4 bit counters, two per byte,
+* that are halved now and then, so it tracks recent popularity.  When a shard is full a newcomer
+* replaces the least recently used entry only if it is the more popular of
+* the two, so a scan of one-off names can not flush the hot accounts.
+*
+* Invalidation is strict.  A miss returns the shard's generation; the caller
+* reads the database and inserts with that generation.  invalidate() bumps
+* the generation, so a value read before a change was committed, but offered
+* after it, is refused rather than cached.
+*
+-->
+gamzia::AccountCache cache = gamzia::AccountCache(1 << 20);
+std::string hash;
+uint64_t generation;
+
+if (!cache.lookup(user, hash, generation))
+{
+   hash = readFromDatabase(user);
+   cache.insert(user, hash, generation);
+}
+...
+cache.invalidate(user);          // after the change is committed
+std::cout << cache.getHitRate() << std::endl;
+<--
+*/
+
+#include "AccountCache.h"
+#include <algorithm>
+#include <functional>
+
+
+/// <summary>
+/// Constructor.
+/// </summary>
+/// <param name="maxBytes">Memory budget, split evenly among the shards.</param>
+/// <param name="shards">Number of independently locked shards.</param>
+gamzia::AccountCache::AccountCache(size_t maxBytes, size_t shards)
+{
+   myshardcount = std::max(shards, (size_t)1);
+   myshardbytes = std::max(maxBytes / myshardcount, (size_t)1);
+   myshards = std::make_unique<Shard[]>(myshardcount);
+
+   // About one counter per entry that fits, hash and a short name assumed
+   size_t width = 64;
+   while (width < myshardbytes / (ENTRY_OVERHEAD + 80))
+      width <<= 1;
+   for (size_t i = 0; i < myshardcount; i++)
+   {
+      myshards[i].sketch.assign(SKETCH_ROWS * width / 2, 0);
+      myshards[i].mask = width - 1;
+   }
+}
+
+/// <summary>
+/// Looks up a user's hash.  Counts towards the user's popularity either way.
+/// </summary>
+/// <param name="user">The user name (any case).</param>
+/// <param name="value">Receives the hash on a hit.</param>
+/// <param name="generation">Receives, on a miss, the generation to pass to insert().</param>
+/// <returns>True on a hit.</returns>
+bool gamzia::AccountCache::lookup(const std::string& user, std::string& value, uint64_t& generation)
+{
+   std::string key = normalize(user);
+   size_t hash = std::hash<std::string>{}(key);
+   Shard& shard = shardOf(hash);
+
+   std::lock_guard<std::mutex> guard(shard.lock);
+   record(shard, hash);
+   auto found = shard.index.find(key);
+   if (found == shard.index.end())
+   {
+      generation = shard.generation;
+      shard.stats.misses++;
+      return false;
+   }
+
+   shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+   value = found->second->value;
+   shard.stats.hits++;
+   return true;
+}
+
+/// <summary>
+/// Caches a value read from the database after a miss.  Refused if the user
+/// (or another in the same shard) was invalidated since that lookup, if it
+/// does not fit, or if admission prefers the entry it would evict.
+/// </summary>
+/// <param name="user">The user name (any case).</param>
+/// <param name="value">The hash.</param>
+/// <param name="generation">From the lookup() that missed.</param>
+/// <returns>True if cached.</returns>
+bool gamzia::AccountCache::insert(const std::string& user, const std::string& value, uint64_t generation)
+{
+   std::string key = normalize(user);
+   size_t hash = std::hash<std::string>{}(key);
+   Shard& shard = shardOf(hash);
+   size_t cost = key.size() + value.size() + ENTRY_OVERHEAD;
+
+   std::lock_guard<std::mutex> guard(shard.lock);
+   if (generation != shard.generation || cost > myshardbytes)
+   {
+      shard.stats.rejected++;
+      return false;
+   }
+
+   auto found = shard.index.find(key);
+   if (found != shard.index.end())
+   {
+      // Someone else loaded it meanwhile; same generation, so same value
+      shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+      return true;
+   }
+
+   if (shard.bytes + cost > myshardbytes && !shard.lru.empty())
+   {
+      size_t victim = std::hash<std::string>{}(shard.lru.back().key);
+      if (estimate(shard, hash) <= estimate(shard, victim))
+      {
+         shard.stats.rejected++;
+         return false;
+      }
+   }
+   while (shard.bytes + cost > myshardbytes && !shard.lru.empty())
+      evict(shard);
+
+   shard.lru.push_front(Entry{ std::move(key), value });
+   shard.index[shard.lru.front().key] = shard.lru.begin();
+   shard.bytes += cost;
+   shard.stats.inserts++;
+   return true;
+}
+
+/// <summary>
+/// Drops a user's entry; call after a change to the user is committed.
+/// Loads of the shard that started earlier are refused by insert().
+/// </summary>
+/// <param name="user">The user name (any case).</param>
+void gamzia::AccountCache::invalidate(const std::string& user)
+{
+   std::string key = normalize(user);
+   size_t hash = std::hash<std::string>{}(key);
+   Shard& shard = shardOf(hash);
+
+   std::lock_guard<std::mutex> guard(shard.lock);
+   shard.generation++;
+   shard.stats.invalidations++;
+   auto found = shard.index.find(key);
+   if (found == shard.index.end())
+      return;
+
+   std::list<Entry>::iterator entry = found->second;
+   shard.bytes -= entry->key.size() + entry->value.size() + ENTRY_OVERHEAD;
+   shard.index.erase(found);
+   shard.lru.erase(entry);
+}
+
+/// <summary>
+/// Drops everything, ie, after a bulk change.  Statistics are kept.
+/// </summary>
+void gamzia::AccountCache::clear()
+{
+   for (size_t i = 0; i < myshardcount; i++)
+   {
+      Shard& shard = myshards[i];
+      std::lock_guard<std::mutex> guard(shard.lock);
+      shard.generation++;
+      shard.index.clear();
+      shard.lru.clear();
+      shard.bytes = 0;
+   }
+}
+
+gamzia::AccountCacheStats gamzia::AccountCache::getStats()
+{
+   AccountCacheStats total = AccountCacheStats();
+
+   for (size_t i = 0; i < myshardcount; i++)
+   {
+      Shard& shard = myshards[i];
+      std::lock_guard<std::mutex> guard(shard.lock);
+      total.hits += shard.stats.hits;
+      total.misses += shard.stats.misses;
+      total.inserts += shard.stats.inserts;
+      total.rejected += shard.stats.rejected;
+      total.evictions += shard.stats.evictions;
+      total.invalidations += shard.stats.invalidations;
+      total.entries += shard.lru.size();
+      total.bytes += shard.bytes;
+   }
+   return (total);
+}
+
+/// <summary>
+/// Hits / lookups so far.
+/// </summary>
+/// <returns>From 0 to 1; 0 before the first lookup.</returns>
+double gamzia::AccountCache::getHitRate()
+{
+   AccountCacheStats stats = getStats();
+   unsigned long long lookups = stats.hits + stats.misses;
+   return (lookups == 0 ? 0.0 : (double)stats.hits / (double)lookups);
+}
+
+/// <summary>
+/// The accounts table compares names with COLLATE NOCASE, which folds ASCII
+/// only; so does this.
+/// </summary>
+std::string gamzia::AccountCache::normalize(const std::string& user)
+{
+   std::string key = user;
+   for (char& c : key)
+   {
+      if (c >= 'A' && c <= 'Z')
+         c = (char)(c - 'A' + 'a');
+   }
+   return (key);
+}
+
+gamzia::AccountCache::Shard& gamzia::AccountCache::shardOf(size_t hash)
+{
+   // High bits: the sketch uses the low ones
+   return (myshards[(size_t)(((uint64_t)hash * 0x9E3779B97F4A7C15ULL) >> 32) % myshardcount]);
+}
+
+size_t gamzia::AccountCache::slotOf(const Shard& shard, size_t hash, size_t row)
+{
+   static const uint64_t seeds[SKETCH_ROWS] =
+      { 0xC3A5C85C97CB3127ULL, 0xB492B66FBE98F273ULL, 0x9AE16A3B2F90404FULL, 0xCBF29CE484222325ULL };
+
+   uint64_t x = ((uint64_t)hash ^ (uint64_t)row) * seeds[row];
+   x ^= x >> 29;
+   return (row * (shard.mask + 1) + (size_t)(x & shard.mask));
+}
+
+uint8_t gamzia::AccountCache::getCounter(const Shard& shard, size_t slot)
+{
+   return ((shard.sketch[slot >> 1] >> ((slot & 1) * 4)) & 0x0F);
+}
+
+void gamzia::AccountCache::setCounter(Shard& shard, size_t slot, uint8_t value)
+{
+   uint8_t& pair = shard.sketch[slot >> 1];
+   unsigned shift = (unsigned)(slot & 1) * 4;
+   pair = (uint8_t)((pair & ~(0x0F << shift)) | ((value & 0x0F) << shift));
+}
+
+/// <summary>
+/// Counts one access in the sketch.  After ten accesses per counter, all
+/// counters are halved, so old popularity fades.
+/// </summary>
+void gamzia::AccountCache::record(Shard& shard, size_t hash)
+{
+   for (size_t row = 0; row < SKETCH_ROWS; row++)
+   {
+      size_t slot = slotOf(shard, hash, row);
+      uint8_t counter = getCounter(shard, slot);
+      if (counter < SKETCH_MAX)
+         setCounter(shard, slot, counter + 1);
+   }
+
+   if (++shard.samples >= 10 * (shard.mask + 1))
+   {
+      // Both counters of a byte at once; the mask stops bits crossing over
+      for (uint8_t& pair : shard.sketch)
+         pair = (uint8_t)((pair >> 1) & 0x77);
+      shard.samples /= 2;
+   }
+}
+
+unsigned gamzia::AccountCache::estimate(const Shard& shard, size_t hash)
+{
+   unsigned count = SKETCH_MAX;
+
+   for (size_t row = 0; row < SKETCH_ROWS; row++)
+      count = std::min<unsigned>(count, getCounter(shard, slotOf(shard, hash, row)));
+   return (count);
+}
+
+/// <summary>
+/// Drops the least recently used entry; shard locked.
+/// </summary>
+void gamzia::AccountCache::evict(Shard& shard)
+{
+   Entry& entry = shard.lru.back();
+   shard.bytes -= entry.key.size() + entry.value.size() + ENTRY_OVERHEAD;
+   shard.index.erase(entry.key);
+   shard.lru.pop_back();
+   shard.stats.evictions++;
+}
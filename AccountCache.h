@@ -0,0 +1,89 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+namespace gamzia
+{
+
+   struct AccountCacheStats
+   {
+      unsigned long long hits;
+      unsigned long long misses;
+      unsigned long long inserts;
+      unsigned long long rejected;        // refused by admission, or stale
+      unsigned long long evictions;
+      unsigned long long invalidations;
+      unsigned long long entries;
+      unsigned long long bytes;
+   };
+
+   /// <summary>
+   /// A thread safe, sharded, memory bounded cache of user name to password
+   /// hash, for AccountManager.  Names are matched case insensitively, like
+   /// the accounts table.  Each shard is an LRU list with TinyLFU admission:
+   /// when full, a new entry only gets in if it has been asked for more
+   /// often than the entry it would evict.
+   /// </summary>
+   class AccountCache
+   {
+
+   public:
+      AccountCache(size_t maxBytes = MAX_BYTES, size_t shards = SHARDS);
+      AccountCache(const AccountCache&) = delete;
+      AccountCache& operator=(const AccountCache&) = delete;
+
+      bool lookup(const std::string& user, std::string& value, uint64_t& generation);
+      bool insert(const std::string& user, const std::string& value, uint64_t generation);
+      void invalidate(const std::string& user);
+      void clear();
+      AccountCacheStats getStats();
+      double getHitRate();
+
+      inline static const size_t MAX_BYTES = 4 << 20;
+      inline static const size_t SHARDS = 16;
+      inline static const size_t ENTRY_OVERHEAD = 96;    // list node, map node, string headers
+
+   private:
+      struct Entry
+      {
+         std::string key;
+         std::string value;
+      };
+
+      struct Shard
+      {
+         std::mutex lock;
+         std::list<Entry> lru;               // most recent first
+         std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+         size_t bytes = 0;
+         uint64_t generation = 0;
+         std::vector<uint8_t> sketch;        // count-min, SKETCH_ROWS x width, two per byte
+         size_t mask = 0;
+         size_t samples = 0;
+         AccountCacheStats stats = AccountCacheStats();
+      };
+
+      std::unique_ptr<Shard[]> myshards;
+      size_t myshardcount;
+      size_t myshardbytes;
+
+      inline static const size_t SKETCH_ROWS = 4;
+      inline static const uint8_t SKETCH_MAX = 15;
+
+      static std::string normalize(const std::string& user);
+      Shard& shardOf(size_t hash);
+      static size_t slotOf(const Shard& shard, size_t hash, size_t row);
+      static uint8_t getCounter(const Shard& shard, size_t slot);
+      static void setCounter(Shard& shard, size_t slot, uint8_t value);
+      static void record(Shard& shard, size_t hash);
+      static unsigned estimate(const Shard& shard, size_t hash);
+      static void evict(Shard& shard);
+   }; // class
+
+}; // namespace
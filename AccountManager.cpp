@@ -1,291 +1,603 @@
-#include "AccountManager.h"
-#include <string>
-#include <sstream>
-#include <iostream>
-#include <vector>
-#include <time.h>
-#include <iomanip>
-#include <boost/algorithm/string.hpp>
-#include <filesystem>
-#include "Sqlite.h"
-#include "SHA256.h"
-
-
-/// <summary>
-/// Default constructor.  Use this one for general use.
-/// </summary>
-gamzia::AccountManager::AccountManager()
-{
-   mydb = gamzia::Sqlite(DBNAME);
-   mydb.connect();
-   if (!doesTableExist())
-      createAccountsTable();
-}
-
-
-/// <summary>
-/// Optional constructor takes the name of a DB to use.
-/// </summary>
-/// <param name="dbname">The name of the database to use.</param>
-gamzia::AccountManager::AccountManager(std::string dbname)
-{
-   mydb = gamzia::Sqlite(dbname);
-   mydb.connect();
-   if (!doesTableExist())
-      createAccountsTable();
-}
-
-
-/// <summary>
-/// Deconstructor does cleanup.
-/// </summary>
-gamzia::AccountManager::~AccountManager()
-{
-   mydb.close();
-   mydb.~Sqlite();
-}
-
-
-/// <summary>
-/// An internal test to look for the accounts table.
-/// </summary>
-/// <returns>True if table schema exists.</returns>
-bool gamzia::AccountManager::doesTableExist()
-{
-   gamzia::Cursor k = mydb.getCursor();
-   return (k.doesTableExist(TABLENAME));
-}
-
-
-/// <summary>
-/// Creates the accounts table.  Only used for new dbs.
-/// Sets username column to unique, case insensitive.
-/// </summary>
-/// <returns>True on success.</returns>
-bool gamzia::AccountManager::createAccountsTable()
-{
-   std::string sql;
-
-   sql = "CREATE TABLE accounts (id INTEGER PRIMARY KEY AUTOINCREMENT, " \
-      "user TEXT UNIQUE COLLATE NOCASE, password, created)";
-   gamzia::Cursor k = mydb.getCursor();
-   if (!k.execute(sql))
-      return false;
-   return (k.commit());
-}
-
-/// <summary>
-/// Returns true if user account exists in table.
-/// </summary>
-/// <param name="user">The user name to verify.</param>
-/// <returns>True if user exists, false otherwise.</returns>
-bool gamzia::AccountManager::doesUserExist(std::string user)
-{
-   std::string sql;
-   std::vector<std::string> params;
-   std::vector<std::string> row;
-
-   sql = "SELECT count(user) FROM accounts WHERE user=?";
-   params.clear();
-   params.push_back(user);
-   gamzia::Cursor k = mydb.getCursor();
-   k.execute(sql, params);
-   row = k.fetchOne();
-   if (row.empty())
-      return false;
-
-   if (row[0] == "0")
-      return(false);
-
-   return true;
-}
-
-/// <summary>
-/// C-RUD Adds a user. Salts the password.
-/// </summary>
-/// <param name="user">User name to add.</param>
-/// <param name="password">Plaintext password.</param>
-/// <returns>True on success, false otherwise.</returns>
-bool gamzia::AccountManager::addUser(std::string user, std::string password)
-{
-   std::string sql;
-   std::string saltedPassword;
-   std::vector<std::string> params;
-   time_t now;
-
-   if (doesUserExist(user))
-      return false;
-
-   now = time(0);
-   saltedPassword = AccountManager::saltPassword(user, password);
-   sql = "INSERT INTO accounts (user, password, created) VALUES (?, ?, ?)";
-   params.clear();
-   params.push_back(user);
-   params.push_back(saltedPassword);
-   params.push_back(std::to_string(now));
-   gamzia::Cursor k = mydb.getCursor();
-   if (!k.execute(sql, params))
-      return (false);
-   return (k.commit());
-}
-
-
-/// <summary>
-/// C - R - UD -> Returns all records in account database as a vector. 
-/// </summary>
-/// <returns>The table; or an empty list if no records available.</returns>
-std::vector<std::string> gamzia::AccountManager::listUsers()
-{
-   std::string sql;
-   std::vector<std::string> table;
-
-   gamzia::Cursor k = mydb.getCursor();
-   sql = "SELECT * FROM " + TABLENAME;
-   k.execute(sql);
-   table = k.fetchAll();
-   return (table);
-}
-
-
-/// <summary>
-/// C - R - UD -> returns a user record as a vector of string.
-/// </summary>
-/// <param name="user">The user name to load.</param>
-/// <returns>The user record, if it exists; empty otherwise.</returns>
-std::vector<std::string> gamzia::AccountManager::getUser(std::string user)
-{
-   std::string sql;
-   std::vector<std::string> params;
-
-   gamzia::Cursor k = mydb.getCursor();
-   sql = "SELECT * FROM ? WHERE user=?";
-   params.clear();
-   params.push_back(TABLENAME);
-   params.push_back(user);
-   k.execute(sql, params);
-   return (k.fetchOne());
-}
-
-
-/// <summary>
-/// # C-R-UD -> Loads password field only, for a given user account.
-/// </summary>
-/// <param name="user">The user account to access.</param>
-/// <returns>The password, or empty string if none.</returns>
-std::string gamzia::AccountManager::getPassword(std::string user)
-{
-   std::string sql;
-   std::vector<std::string> params;
-   std::vector<std::string> record;
-
-   gamzia::Cursor k = mydb.getCursor();
-   sql = "SELECT password FROM ? WHERE user=?";
-   params.clear();
-   params.push_back(TABLENAME);
-   params.push_back(user);
-   k.execute(sql, params);
-   record = k.fetchOne();
-   if (!record.empty())
-      return (record[0]);
-   
-   // No password, or user not found
-   return "";
-}
-
-
-/// <summary>
-/// CR - U - D -> Updates user record password
-/// </summary>
-/// <param name="user">The user account to update.</param>
-/// <param name="password">The plaintext password.</param>
-/// <returns></returns>
-bool gamzia::AccountManager::updatePassword(std::string user, std::string password)
-{
-   std::string sql;
-   std::string saltedPassword;
-   std::vector<std::string> params;
-
-   saltedPassword = AccountManager::saltPassword(user, password);
-   gamzia::Cursor k = mydb.getCursor();
-   sql = "UPDATE ? SET password=? WHERE user=?";
-   params.clear();
-   params.push_back(TABLENAME);
-   params.push_back(saltedPassword);
-   params.push_back(user);
-   if (!k.execute(sql, params))
-      return false;
-   return (k.commit());
-}
-
-
-/// <summary>
-/// CRU - D -> Deletes record by user name
-/// </summary>
-/// <param name="user">The user name.</param>
-/// <returns>True on success.</returns>
-bool gamzia::AccountManager::deleteUser(std::string user)
-{
-   std::string sql;
-   std::vector<std::string> params;
-
-   gamzia::Cursor k = mydb.getCursor();
-   sql = "DELETE FROM ? WHERE user=?";
-   params.clear();
-   params.push_back(TABLENAME);
-   params.push_back(user);
-   if (!k.execute(sql, params))
-      return (false);
-
-   // Commit and reclaim the file space
-   if (!k.commit())
-      return (false);
-   k.vacuum();
-
-   // Success
-   return true;
-}
-
-
-/// <summary>
-/// Compares a salted password hash to the one in the DB.
-/// DO NOT PROVIDE A PASSWORD AS THE PARAMETER.
-/// A PRE - SALTED, PRE - HASHED STRING IS EXPECTED (ie, the client program
-/// should never provide an actual password; everything is done with
-/// irreversible salted hashes for security purposes.
-/// </summary>
-/// <param name="user">The user account to test.</param>
-/// <param name="saltedPassword">The salted password to test.</param>
-/// <returns>True on match, false otherwise.</returns>
-bool gamzia::AccountManager::verifyPassword(std::string user, std::string saltedPassword)
-{
-   std::string hash;
-
-   // Get password from DB, check it against supplied
-   hash = getPassword(user);
-   if (hash == saltedPassword)
-      return true;
-
-   // Anything else is a failure
-   return false;
-}
-
-
-/// <summary>
-/// Applies the salt formula and produces the SHA256 hash.
-/// </summary>
-/// <param name="user">The user account.  Used in salt formula.</param>
-/// <param name="password">The plaintext password.</param>
-/// <returns>A salted SHA526 hash.</returns>
-std::string gamzia::AccountManager::saltPassword(std::string user, std::string password)
-{
-   std::string presalt;
-   std::string saltedHash;
-
-   presalt = user + password + user;
-   saltedHash = sha256(presalt);
-   boost::algorithm::to_lower(saltedHash);
-   return (saltedHash);
-}
-
-
-
+#include "AccountManager.h"
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <time.h>
+#include <iomanip>
+#include <filesystem>
+#include <algorithm>
+#include "Sqlite.h"
+#include "SHA256.h"
+
+
+/// <summary>
+/// Default constructor.  Use this one for general use.
+/// </summary>
+gamzia::AccountManager::AccountManager()
+{
+   mydbname = DBNAME;
+   myfilterrate = CountingBloomFilter::FALSE_POSITIVE_RATE;
+   mydb = gamzia::Sqlite(DBNAME);
+   mydb.connect();
+   if (!doesTableExist())
+      createAccountsTable();
+}
+
+
+/// <summary>
+/// Optional constructor takes the name of a DB to use.
+/// </summary>
+/// <param name="dbname">The name of the database to use.</param>
+gamzia::AccountManager::AccountManager(std::string dbname)
+{
+   mydbname = dbname;
+   myfilterrate = CountingBloomFilter::FALSE_POSITIVE_RATE;
+   mydb = gamzia::Sqlite(dbname);
+   mydb.connect();
+   if (!doesTableExist())
+      createAccountsTable();
+}
+
+
+/// <summary>
+/// Deconstructor does cleanup.
+/// </summary>
+gamzia::AccountManager::~AccountManager()
+{
+   stopMaintenance();
+   mydb.close();
+}
+
+
+/// <summary>
+/// An internal test to look for the accounts table.
+/// </summary>
+/// <returns>True if table schema exists.</returns>
+bool gamzia::AccountManager::doesTableExist()
+{
+   gamzia::Cursor k = mydb.getCursor();
+   return (k.doesTableExist(TABLENAME));
+}
+
+
+/// <summary>
+/// Creates the accounts table.  Only used for new dbs.
+/// Sets username column to unique, case insensitive.
+/// A new, empty db file is set to incremental auto vacuum, so deleted
+/// accounts' pages can be reclaimed a few at a time (see startMaintenance()).
+/// </summary>
+/// <returns>True on success.</returns>
+bool gamzia::AccountManager::createAccountsTable()
+{
+   std::string sql;
+
+   // Free only while the file is empty.  A db that already holds other
+   // tables would need a full VACUUM: that is left to startMaintenance()
+   if (mydb.getPageCount() == 0 && !mydb.setAutoVacuum("incremental"))
+      return false;
+
+   sql = "CREATE TABLE accounts (id INTEGER PRIMARY KEY AUTOINCREMENT, " \
+      "user TEXT UNIQUE COLLATE NOCASE, password, created)";
+   gamzia::Cursor k = mydb.getCursor();
+   if (!k.execute(sql))
+      return false;
+   return (k.commit());
+}
+
+/// <summary>
+/// Returns true if user account exists in table.
+/// </summary>
+/// <param name="user">The user name to verify.</param>
+/// <returns>True if user exists, false otherwise.</returns>
+bool gamzia::AccountManager::doesUserExist(std::string user)
+{
+   std::string sql;
+   std::vector<std::string> params;
+   std::vector<std::string> row;
+
+   // A definite miss needs no query
+   if (myfilter && !myfilter->mightContain(foldCase(user)))
+      return false;
+
+   sql = "SELECT count(user) FROM accounts WHERE user=?";
+   params.clear();
+   params.push_back(user);
+   gamzia::Cursor k = mydb.getCursor();
+   k.execute(sql, params);
+   row = k.fetchOne();
+   if (row.empty())
+      return false;
+
+   if (row[0] == "0")
+      return(false);
+
+   return true;
+}
+
+/// <summary>
+/// C-RUD Adds a user. Salts the password.
+/// </summary>
+/// <param name="user">User name to add.</param>
+/// <param name="password">Plaintext password.</param>
+/// <returns>True on success, false otherwise.</returns>
+bool gamzia::AccountManager::addUser(std::string user, std::string password)
+{
+   std::string sql;
+   std::string saltedPassword;
+   std::vector<std::string> params;
+   time_t now;
+
+   if (doesUserExist(user))
+      return false;
+
+   now = time(0);
+   saltedPassword = AccountManager::saltPassword(user, password);
+   sql = "INSERT INTO accounts (user, password, created) VALUES (?, ?, ?)";
+   params.clear();
+   params.push_back(user);
+   params.push_back(saltedPassword);
+   params.push_back(std::to_string(now));
+   gamzia::Cursor k = mydb.getCursor();
+   bool ok = k.execute(sql, params) && k.commit();
+   invalidate(user);
+   if (ok && myfilter)
+   {
+      myfilter->add(foldCase(user));
+      growUserFilter();
+   }
+   return (ok);
+}
+
+
+/// <summary>
+/// C-RUD Adds many users at once (ie: an import).  Passwords are salted as
+/// in addUser(); names that already exist are skipped.  Rows go through
+/// Cursor::executeMany(), so there is one reused statement and a COMMIT
+/// per batch rather than per user.
+/// </summary>
+/// <param name="users">Pairs of user name and plaintext password.</param>
+/// <returns>True on success, false otherwise.</returns>
+bool gamzia::AccountManager::addUsers(const std::vector<std::pair<std::string, std::string>>& users)
+{
+   std::string sql;
+   std::vector<std::vector<std::string>> rows;
+   gamzia::ExecuteManyOptions options;
+   std::string now;
+
+   now = std::to_string(time(0));
+   rows.reserve(users.size());
+   for (const auto& user : users)
+      rows.push_back({ user.first, AccountManager::saltPassword(user.first, user.second), now });
+
+   sql = "INSERT OR IGNORE INTO " + TABLENAME + " (user, password, created) VALUES (?, ?, ?)";
+   options.rowsPerStatement = 32;
+   gamzia::Cursor k = mydb.getCursor();
+   bool ok = k.executeMany(sql, rows, options);
+   for (const auto& user : users)
+   {
+      invalidate(user.first);
+
+      // Skipped and failed names too: an extra entry only costs a query
+      if (myfilter)
+         myfilter->add(foldCase(user.first));
+   }
+   growUserFilter();
+   return (ok);
+}
+
+
+/// <summary>
+/// C - R - UD -> Returns all records in account database as a vector. 
+/// Holds the whole table in memory; for large tables use forEachUser() or
+/// the paged listUsers().
+/// </summary>
+/// <returns>The table; or an empty list if no records available.</returns>
+std::vector<std::string> gamzia::AccountManager::listUsers()
+{
+   std::string sql;
+   std::vector<std::string> table;
+
+   gamzia::Cursor k = mydb.getCursor();
+   sql = "SELECT * FROM " + TABLENAME;
+   k.execute(sql);
+   table = k.fetchAll();
+   return (table);
+}
+
+
+/// <summary>
+/// C - R - UD -> Returns one page of records, in id order, in the same
+/// layout as listUsers() (column names first).  Pass 0 for the first page,
+/// then the id of the last record returned for the next one.  Each page
+/// is an index seek, however deep into the table it is.
+/// </summary>
+/// <param name="afterId">Id of the last record of the previous page.</param>
+/// <param name="limit">Maximum records per page.</param>
+/// <returns>The page; or an empty list past the last record.</returns>
+std::vector<std::string> gamzia::AccountManager::listUsers(long long afterId, int limit)
+{
+   std::vector<std::string> table;
+
+   gamzia::Cursor k = mydb.getCursor();
+   for (gamzia::Row row : k.queryPage(TABLENAME, "*", "id", std::to_string(afterId), limit))
+   {
+      int columns = row.getColumnCount();
+      if (table.empty())
+      {
+         for (int i = 0; i < columns; i++)
+            table.push_back(row.getColumnName(i));
+      }
+      for (int i = 0; i < columns; i++)
+         table.push_back(row.getString(i));
+   }
+   return (table);
+}
+
+
+/// <summary>
+/// C - R - UD -> Streams every record to a visitor, one row at a time, in
+/// id order.  Memory use is constant regardless of table size.  The Row is
+/// only valid during the call.
+/// </summary>
+/// <param name="visitor">Called per record; return false to stop early.</param>
+/// <returns>False if the query failed; true otherwise.</returns>
+bool gamzia::AccountManager::forEachUser(std::function<bool(const Row&)> visitor)
+{
+   std::string sql;
+
+   gamzia::Cursor k = mydb.getCursor();
+   sql = "SELECT * FROM " + TABLENAME + " ORDER BY id";
+   gamzia::Query rows = k.query(sql);
+   if (!rows.isValid())
+      return (false);
+
+   for (gamzia::Row row : rows)
+   {
+      if (!visitor(row))
+         break;
+   }
+   return (true);
+}
+
+
+/// <summary>
+/// C - R - UD -> returns a user record as a vector of string.
+/// </summary>
+/// <param name="user">The user name to load.</param>
+/// <returns>The user record, if it exists; empty otherwise.</returns>
+std::vector<std::string> gamzia::AccountManager::getUser(std::string user)
+{
+   std::string sql;
+   std::vector<std::string> params;
+
+   gamzia::Cursor k = mydb.getCursor();
+   sql = "SELECT * FROM " + TABLENAME + " WHERE user=?";
+   params.clear();
+   params.push_back(user);
+   k.execute(sql, params);
+   return (k.fetchOne());
+}
+
+
+/// <summary>
+/// # C-R-UD -> Loads password field only, for a given user account.
+/// </summary>
+/// <param name="user">The user account to access.</param>
+/// <returns>The password, or empty string if none.</returns>
+std::string gamzia::AccountManager::getPassword(std::string user)
+{
+   std::string sql;
+   std::vector<std::string> params;
+   std::vector<std::string> record;
+   std::string hash;
+   uint64_t generation = 0;
+
+   // Unknown users are answered by the filter, known ones by the cache
+   if (myfilter && !myfilter->mightContain(foldCase(user)))
+      return "";
+   if (mycache && mycache->lookup(user, hash, generation))
+      return (hash);
+
+   gamzia::Cursor k = mydb.getCursor();
+   sql = "SELECT password FROM " + TABLENAME + " WHERE user=?";
+   params.clear();
+   params.push_back(user);
+   k.execute(sql, params);
+   record = k.fetchOne();
+   if (!record.empty())
+   {
+      if (mycache)
+         mycache->insert(user, record[0], generation);
+      return (record[0]);
+   }
+   
+   // No password, or user not found
+   return "";
+}
+
+
+/// <summary>
+/// CR - U - D -> Updates user record password
+/// </summary>
+/// <param name="user">The user account to update.</param>
+/// <param name="password">The plaintext password.</param>
+/// <returns></returns>
+bool gamzia::AccountManager::updatePassword(std::string user, std::string password)
+{
+   std::string sql;
+   std::string saltedPassword;
+   std::vector<std::string> params;
+
+   saltedPassword = AccountManager::saltPassword(user, password);
+   gamzia::Cursor k = mydb.getCursor();
+   sql = "UPDATE " + TABLENAME + " SET password=? WHERE user=?";
+   params.clear();
+   params.push_back(saltedPassword);
+   params.push_back(user);
+   bool ok = k.execute(sql, params) && k.commit();
+   invalidate(user);
+   return (ok);
+}
+
+
+/// <summary>
+/// CRU - D -> Deletes record by user name
+/// </summary>
+/// <param name="user">The user name.</param>
+/// <returns>True on success.</returns>
+bool gamzia::AccountManager::deleteUser(std::string user)
+{
+   std::string sql;
+   std::vector<std::string> params;
+
+   gamzia::Cursor k = mydb.getCursor();
+   sql = "DELETE FROM " + TABLENAME + " WHERE user=?";
+   params.clear();
+   params.push_back(user);
+   bool ok = k.execute(sql, params);
+   bool isDeleted = (ok && sqlite3_changes(mydb.getHandle()) > 0);
+   ok = ok && k.commit();
+   invalidate(user);
+   if (!ok)
+      return (false);
+
+   // Only what is really gone: removing an absent name could hide another
+   if (isDeleted && myfilter)
+      myfilter->remove(foldCase(user));
+
+   // The freed pages are left for the maintenance scheduler: a VACUUM
+   // here would rewrite the whole file on every delete
+
+   // Success
+   return true;
+}
+
+
+/// <summary>
+/// Compares a salted password hash to the one in the DB.
+/// DO NOT PROVIDE A PASSWORD AS THE PARAMETER.
+/// A PRE - SALTED, PRE - HASHED STRING IS EXPECTED (ie, the client program
+/// should never provide an actual password; everything is done with
+/// irreversible salted hashes for security purposes.
+/// </summary>
+/// <param name="user">The user account to test.</param>
+/// <param name="saltedPassword">The salted password to test.</param>
+/// <returns>True on match, false otherwise.</returns>
+bool gamzia::AccountManager::verifyPassword(std::string user, std::string saltedPassword)
+{
+   std::string hash;
+
+   // Get password from DB, check it against supplied
+   hash = getPassword(user);
+   if (hash == saltedPassword)
+      return true;
+
+   // Anything else is a failure
+   return false;
+}
+
+
+/// <summary>
+/// Starts background maintenance of the accounts db (MaintenanceScheduler):
+/// space left by deleted users is reclaimed in small steps when the db is
+/// idle, and the planner statistics are kept current.  A db created before
+/// incremental auto vacuum is converted first, with one full VACUUM.
+/// </summary>
+/// <param name="options">Scheduling options.</param>
+/// <returns>True if the scheduler is running.</returns>
+bool gamzia::AccountManager::startMaintenance(MaintenanceOptions options)
+{
+   stopMaintenance();
+   if (!mydb.setAutoVacuum("incremental"))
+      return false;
+
+   mymaintenance = std::make_unique<MaintenanceScheduler>(mydbname, options);
+   if (!mymaintenance->isReady())
+   {
+      mymaintenance.reset();
+      return false;
+   }
+   mymaintenance->start();
+   return true;
+}
+
+
+void gamzia::AccountManager::stopMaintenance()
+{
+   mymaintenance.reset();
+}
+
+
+/// <summary>
+/// Puts an AccountCache in front of getPassword() / verifyPassword(), so
+/// repeated logins for the same accounts are answered from memory.  Changes
+/// made through this AccountManager invalidate it; changes made to the db
+/// by anyone else (another process, a raw connection) do not, so only
+/// enable it when this instance is the db's only writer.
+/// </summary>
+/// <param name="maxBytes">Memory budget for the cache.</param>
+void gamzia::AccountManager::enableCache(size_t maxBytes)
+{
+   mycache = std::make_unique<AccountCache>(maxBytes);
+}
+
+
+void gamzia::AccountManager::disableCache()
+{
+   mycache.reset();
+}
+
+
+/// <summary>
+/// Hit, miss, admission and eviction counts of the cache; all zero if the
+/// cache is not enabled.
+/// </summary>
+/// <returns>The statistics.</returns>
+gamzia::AccountCacheStats gamzia::AccountManager::getCacheStats()
+{
+   if (!mycache)
+      return (AccountCacheStats());
+   return (mycache->getStats());
+}
+
+
+/// <summary>
+/// Keeps a counting Bloom filter of the user names (case folded, like the
+/// NOCASE column) in memory, so that doesUserExist() and getPassword() /
+/// verifyPassword() answer most names that do not exist - ie, the bulk of
+/// a credential stuffing attack - without a query.  Built by streaming the
+/// table now; kept current by addUser(), addUsers() and deleteUser(), and
+/// rebuilt larger when the table outgrows it.  As with enableCache(), users
+/// added to the db by anyone else would be missed: this instance must be
+/// the db's only writer.
+/// </summary>
+/// <param name="falsePositiveRate">Rate of absent names that still cost a query.</param>
+/// <returns>True if the filter was built.</returns>
+bool gamzia::AccountManager::enableUserFilter(double falsePositiveRate)
+{
+   std::vector<std::string> row;
+
+   myfilterrate = falsePositiveRate;
+   gamzia::Cursor k = mydb.getCursor();
+   if (!k.execute("SELECT count(*) FROM " + TABLENAME))
+      return false;
+   row = k.fetchOne();
+   if (row.empty())
+      return false;
+
+   // Room to grow before the first rebuild
+   return (buildUserFilter(2 * (size_t)std::stoull(row[0])));
+}
+
+
+void gamzia::AccountManager::disableUserFilter()
+{
+   myfilter.reset();
+}
+
+
+/// <summary>
+/// Size and effectiveness of the user filter: queries, definite misses
+/// (each one a query saved) and the estimated false positive rate.  All
+/// zero if the filter is not enabled.
+/// </summary>
+/// <returns>The statistics.</returns>
+gamzia::BloomFilterStats gamzia::AccountManager::getUserFilterStats()
+{
+   if (!myfilter)
+      return (BloomFilterStats());
+   return (myfilter->getStats());
+}
+
+
+/// <summary>
+/// (Re)builds the user filter from the table, streamed row by row.
+/// </summary>
+/// <param name="capacity">Names the filter is sized for.</param>
+/// <returns>True on success; the filter is disabled on failure.</returns>
+bool gamzia::AccountManager::buildUserFilter(size_t capacity)
+{
+   std::unique_ptr<CountingBloomFilter> filter;
+   std::string name;
+
+   myfilter.reset();
+   filter = std::make_unique<CountingBloomFilter>(std::max(capacity, MIN_FILTER_CAPACITY), myfilterrate);
+   gamzia::Cursor k = mydb.getCursor();
+   if (!k.execute("SELECT user FROM " + TABLENAME))
+      return false;
+   while (k.step())
+   {
+      name = k.getRow().getText(0);
+      filter->add(foldCase(name));
+   }
+   myfilter = std::move(filter);
+   return true;
+}
+
+
+/// <summary>
+/// Rebuilds the filter at twice the size once it holds more names than it
+/// was sized for, so the false positive rate stays near the one asked for.
+/// </summary>
+void gamzia::AccountManager::growUserFilter()
+{
+   if (myfilter && myfilter->getCount() > myfilter->getCapacity())
+      buildUserFilter(2 * myfilter->getCapacity());
+}
+
+
+/// <summary>
+/// Folds ASCII upper case, as COLLATE NOCASE does (and nothing else).
+/// </summary>
+/// <param name="user">The user name.</param>
+/// <returns>The name in lower case.</returns>
+std::string gamzia::AccountManager::foldCase(const std::string& user)
+{
+   std::string folded = user;
+   for (char& c : folded)
+   {
+      if (c >= 'A' && c <= 'Z')
+         c = (char)(c - 'A' + 'a');
+   }
+   return (folded);
+}
+
+
+/// <summary>
+/// Drops a user from the cache, once a change to it is committed (or has
+/// failed, to be safe).
+/// </summary>
+/// <param name="user">The user name.</param>
+void gamzia::AccountManager::invalidate(const std::string& user)
+{
+   if (mycache)
+      mycache->invalidate(user);
+}
+
+
+/// <summary>
+/// Applies the salt formula and produces the SHA256 hash.
+/// </summary>
+/// <param name="user">The user account.  Used in salt formula.</param>
+/// <param name="password">The plaintext password.</param>
+/// <returns>A salted SHA526 hash.</returns>
+std::string gamzia::AccountManager::saltPassword(std::string user, std::string password)
+{
+   SHA256 ctx = SHA256();
+   SHA256Digest digest;
+   std::string saltedHash(2 * SHA256::DIGEST_SIZE, '0');
+
+   // Salt formula is user + password + user; streamed rather than concatenated.
+   // The hex encoder already produces lowercase.
+   ctx.init();
+   ctx.update(user);
+   ctx.update(password);
+   ctx.update(user);
+   ctx.final(digest.data());
+   sha256ToHex(digest, saltedHash.data());
+   return (saltedHash);
+}
+
+
+
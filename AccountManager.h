@@ -1,42 +1,69 @@
-#pragma once
-#include "Sqlite.h"
-
-
-namespace gamzia
-{
-
-   class AccountManager
-   {
-   public:
-      AccountManager();
-      AccountManager(std::string dbname);
-      ~AccountManager();
-
-      bool doesUserExist(std::string user);
-      bool addUser(std::string user, std::string password);
-      std::vector<std::string> listUsers();
-      std::vector<std::string> getUser(std::string user);
-      std::string getPassword(std::string user);
-      bool updatePassword(std::string user, std::string password);
-      bool deleteUser(std::string user);
-      bool verifyPassword(std::string user, std::string saltedPassword);
-
-      static std::string saltPassword(std::string user, std::string password);
-
-      inline static const std::string DBNAME = "accounts.db";
-      inline static const std::string TABLENAME = "accounts";
-      inline static const std::string TESTDB = "testam.db";
-
-   public:
-      
-
-   private:
-      Sqlite mydb;
-      bool doesTableExist();
-      bool createAccountsTable();
-   
-   };  // Class
-   void doUnitTests();
-}; // Namespace
-
+#pragma once
+#include <functional>
+#include <utility>
+#include <memory>
+#include "Sqlite.h"
+#include "MaintenanceScheduler.h"
+#include "AccountCache.h"
+#include "BloomFilter.h"
+
+
+namespace gamzia
+{
+
+   class AccountManager
+   {
+   public:
+      AccountManager();
+      AccountManager(std::string dbname);
+      ~AccountManager();
+
+      bool doesUserExist(std::string user);
+      bool addUser(std::string user, std::string password);
+      bool addUsers(const std::vector<std::pair<std::string, std::string>>& users);
+      std::vector<std::string> listUsers();
+      std::vector<std::string> listUsers(long long afterId, int limit);
+      bool forEachUser(std::function<bool(const Row&)> visitor);
+      std::vector<std::string> getUser(std::string user);
+      std::string getPassword(std::string user);
+      bool updatePassword(std::string user, std::string password);
+      bool deleteUser(std::string user);
+      bool verifyPassword(std::string user, std::string saltedPassword);
+      bool startMaintenance(MaintenanceOptions options = MaintenanceOptions());
+      void stopMaintenance();
+      void enableCache(size_t maxBytes = AccountCache::MAX_BYTES);
+      void disableCache();
+      AccountCacheStats getCacheStats();
+      bool enableUserFilter(double falsePositiveRate = CountingBloomFilter::FALSE_POSITIVE_RATE);
+      void disableUserFilter();
+      BloomFilterStats getUserFilterStats();
+
+      static std::string saltPassword(std::string user, std::string password);
+
+      inline static const std::string DBNAME = "accounts.db";
+      inline static const std::string TABLENAME = "accounts";
+      inline static const std::string TESTDB = "testam.db";
+      inline static const size_t MIN_FILTER_CAPACITY = 1024;
+
+   public:
+      
+
+   private:
+      Sqlite mydb;
+      std::string mydbname;
+      std::unique_ptr<MaintenanceScheduler> mymaintenance;
+      std::unique_ptr<AccountCache> mycache;
+      std::unique_ptr<CountingBloomFilter> myfilter;
+      double myfilterrate;
+      bool doesTableExist();
+      bool createAccountsTable();
+      void invalidate(const std::string& user);
+      bool buildUserFilter(size_t capacity);
+      void growUserFilter();
+      static std::string foldCase(const std::string& user);
+   
+   };  // Class
+   void doUnitTests();
+}; // Namespace
+
 void doAMUnitTests();
\ No newline at end of file
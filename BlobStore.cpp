@@ -0,0 +1,579 @@
+/*
+* Class BlobStore
+* ===============
+*
+* A content addressed, deduplicating blob store built on the SHA256 and
+* Sqlite classes.
+*
+* Every blob is keyed by the SHA256 digest of its content.  Inserting a blob
+* that is already present only increments its reference count, so identical
+* payloads are stored (and written to disk) once.  Releasing a blob decrements
+* the count; collectGarbage() deletes every blob nobody references any more.
+*
+* Digests are indexed (UNIQUE), so lookups never scan the table.  Large blobs
+* never pass through SQL text or a std::string: space is reserved with a
+* zeroblob and the content is streamed in CHUNK_SIZE pieces through SQLite's
+* incremental blob I/O (BlobStream), in both directions.  open() returns the
+* stream itself, for seeking and ranged reads.
+*
+* Schema (table name is configurable):
+*    id INTEGER PRIMARY KEY, digest BLOB UNIQUE, size INTEGER, refs INTEGER, data BLOB
+*
+-->
+gamzia::Sqlite db = gamzia::Sqlite("reports.db");
+db.connect();
+gamzia::BlobStore store = gamzia::BlobStore(db);
+
+std::string key = store.put(report);      // stored
+std::string same = store.put(report);     // deduplicated; refs == 2
+std::vector<unsigned char> data;
+store.get(key, data);
+
+store.release(key);
+store.release(key);
+store.collectGarbage();                   // removes it
+<--
+*/
+
+#include "BlobStore.h"
+#include <cctype>
+#include <fstream>
+#include "Sqlite.h"
+#include "SHA256.h"
+
+
+/// <summary>
+/// Constructor; uses the default table name.  Creates the schema if needed.
+/// The database must already be connected.
+/// </summary>
+/// <param name="db">An open database.</param>
+gamzia::BlobStore::BlobStore(Sqlite& db)
+   : BlobStore(db, TABLENAME)
+{
+}
+
+
+/// <summary>
+/// Constructor with a table name.  Creates the schema if needed.
+/// </summary>
+/// <param name="db">An open database.</param>
+/// <param name="table">Table name; letters, digits and underscores only.</param>
+gamzia::BlobStore::BlobStore(Sqlite& db, std::string table)
+   : myconnection(db)
+{
+   mydb = db.getHandle();
+   mytable = table;
+   myfind = nullptr;
+   myinsert = nullptr;
+   myupdate = nullptr;
+   mygc = nullptr;
+   isReadyFlag = setup();
+}
+
+
+/// <summary>
+/// Destructor finalizes the prepared statements.
+/// </summary>
+gamzia::BlobStore::~BlobStore()
+{
+   sqlite3_finalize(myfind);
+   sqlite3_finalize(myinsert);
+   sqlite3_finalize(myupdate);
+   sqlite3_finalize(mygc);
+}
+
+
+/// <summary>
+/// True if the schema and statements were set up successfully.
+/// </summary>
+bool gamzia::BlobStore::isReady()
+{
+   return (isReadyFlag);
+}
+
+
+std::string gamzia::BlobStore::getLastError()
+{
+   return (myerror);
+}
+
+
+/// <summary>
+/// Records the connection's current error message.  Always returns false,
+/// so callers can "return fail();".
+/// </summary>
+bool gamzia::BlobStore::fail()
+{
+   if (mydb != nullptr)
+      myerror = sqlite3_errmsg(mydb);
+   return false;
+}
+
+
+/// <summary>
+/// Runs sql on the raw handle.  Like every write here, it may have ended
+/// the transaction (ie, the outermost RELEASE), so the connection's change
+/// subscribers are given the batch.
+/// </summary>
+bool gamzia::BlobStore::exec(const char* sql)
+{
+   int rc = sqlite3_exec(mydb, sql, nullptr, nullptr, nullptr);
+
+   myconnection.flushChanges();
+   if (rc != SQLITE_OK)
+      return fail();
+   return true;
+}
+
+
+bool gamzia::BlobStore::prepare(const std::string& sql, sqlite3_stmt** statement)
+{
+   if (sqlite3_prepare_v2(mydb, sql.c_str(), -1, statement, NULL) != SQLITE_OK)
+      return fail();
+   return true;
+}
+
+
+/// <summary>
+/// Creates the table (and its indexes) if missing, and prepares the
+/// statements used by every call.  They are prepared once and reused.
+/// </summary>
+/// <returns>True on success.</returns>
+bool gamzia::BlobStore::setup()
+{
+   std::string sql;
+
+   if (mydb == nullptr)
+   {
+      myerror = "Database is not connected";
+      return false;
+   }
+
+   // The table name is spliced into SQL, so only allow identifier characters
+   if (mytable.empty())
+   {
+      myerror = "Invalid table name";
+      return false;
+   }
+   for (char c : mytable)
+   {
+      if (!isalnum((unsigned char)c) && c != '_')
+      {
+         myerror = "Invalid table name";
+         return false;
+      }
+   }
+
+   sql = "CREATE TABLE IF NOT EXISTS " + mytable + " (id INTEGER PRIMARY KEY, " \
+      "digest BLOB NOT NULL UNIQUE, size INTEGER NOT NULL, refs INTEGER NOT NULL, data BLOB)";
+   if (!exec(sql.c_str()))
+      return false;
+
+   // Partial index so garbage collection only visits unreferenced rows
+   sql = "CREATE INDEX IF NOT EXISTS " + mytable + "_unreferenced ON " + mytable + " (refs) WHERE refs <= 0";
+   if (!exec(sql.c_str()))
+      return false;
+
+   if (!prepare("SELECT id, size, refs FROM " + mytable + " WHERE digest=?", &myfind))
+      return false;
+   if (!prepare("INSERT INTO " + mytable + " (digest, size, refs, data) VALUES (?, ?, 1, ?)", &myinsert))
+      return false;
+   if (!prepare("UPDATE " + mytable + " SET refs=max(refs+?, 0) WHERE id=?", &myupdate))
+      return false;
+   if (!prepare("DELETE FROM " + mytable + " WHERE refs <= 0", &mygc))
+      return false;
+
+   return true;
+}
+
+
+/// <summary>
+/// Looks a digest up through the unique index.
+/// </summary>
+/// <returns>True if found; the out parameters are set only when found.</returns>
+bool gamzia::BlobStore::find(const SHA256Digest& digest, long long& rowid, long long& size, long long& refs)
+{
+   bool found = false;
+
+   sqlite3_bind_blob(myfind, 1, digest.data(), (int)digest.size(), SQLITE_STATIC);
+   if (sqlite3_step(myfind) == SQLITE_ROW)
+   {
+      rowid = sqlite3_column_int64(myfind, 0);
+      size = sqlite3_column_int64(myfind, 1);
+      refs = sqlite3_column_int64(myfind, 2);
+      found = true;
+   }
+   sqlite3_reset(myfind);
+   sqlite3_clear_bindings(myfind);
+   return (found);
+}
+
+
+bool gamzia::BlobStore::bumpRef(long long rowid, int delta)
+{
+   int rc;
+
+   sqlite3_bind_int(myupdate, 1, delta);
+   sqlite3_bind_int64(myupdate, 2, rowid);
+   rc = sqlite3_step(myupdate);
+   sqlite3_reset(myupdate);
+   myconnection.flushChanges();
+   if (rc != SQLITE_DONE)
+      return fail();
+   return true;
+}
+
+
+/// <summary>
+/// Stores a blob, or adds a reference if the digest is already present.
+/// Runs inside a savepoint, so it is atomic whether or not the caller has a
+/// transaction open.  Small blobs are bound directly; larger ones reserve a
+/// zeroblob and are streamed in by writer through incremental blob I/O.
+/// </summary>
+/// <returns>The hex digest, or an empty string on failure.</returns>
+std::string gamzia::BlobStore::insert(const SHA256Digest& digest, long long size,
+   std::function<bool(BlobStream&)> writer, const void* inlineData)
+{
+   long long rowid = 0;
+   long long existingSize = 0;
+   long long refs = 0;
+   bool ok = true;
+
+   if (!isReadyFlag)
+      return "";
+   if (size > sqlite3_limit(mydb, SQLITE_LIMIT_LENGTH, -1))
+   {
+      myerror = "Blob exceeds the SQLite length limit";
+      return "";
+   }
+
+   if (!exec("SAVEPOINT blobstore_put"))
+      return "";
+
+   if (find(digest, rowid, existingSize, refs))
+      ok = bumpRef(rowid, 1);
+   else
+   {
+      sqlite3_bind_blob(myinsert, 1, digest.data(), (int)digest.size(), SQLITE_STATIC);
+      sqlite3_bind_int64(myinsert, 2, size);
+      if (inlineData != nullptr || size == 0)
+         sqlite3_bind_blob(myinsert, 3, size == 0 ? "" : inlineData, (int)size, SQLITE_STATIC);
+      else
+         sqlite3_bind_zeroblob64(myinsert, 3, (sqlite3_uint64)size);
+
+      ok = (sqlite3_step(myinsert) == SQLITE_DONE);
+      if (!ok)
+         fail();
+      rowid = sqlite3_last_insert_rowid(mydb);
+      sqlite3_reset(myinsert);
+      sqlite3_clear_bindings(myinsert);
+
+      if (ok && writer && inlineData == nullptr && size > 0)
+      {
+         BlobStream blob = BlobStream(mydb, mytable, "data", rowid, true);
+         if (!blob.isOpen())
+            ok = fail();
+         else
+            ok = writer(blob);
+      }
+   }
+
+   if (!ok)
+   {
+      exec("ROLLBACK TO blobstore_put");
+      exec("RELEASE blobstore_put");
+      return "";
+   }
+   if (!exec("RELEASE blobstore_put"))
+      return "";
+
+   return toHex(digest);
+}
+
+
+/// <summary>
+/// Stores a blob from memory.
+/// </summary>
+/// <param name="data">The content.</param>
+/// <param name="len">Content length in bytes.</param>
+/// <returns>The hex SHA256 digest (the blob's key), or an empty string on failure.</returns>
+std::string gamzia::BlobStore::put(const void* data, size_t len)
+{
+   const unsigned char* bytes = (const unsigned char*)data;
+   SHA256Digest digest = sha256Digest(std::span<const std::byte>((const std::byte*)data, len));
+
+   if (len <= CHUNK_SIZE)
+      return insert(digest, (long long)len, nullptr, data);
+
+   return insert(digest, (long long)len, [this, bytes, len](BlobStream& blob)
+   {
+      for (size_t offset = 0; offset < len; offset += CHUNK_SIZE)
+      {
+         size_t n = (len - offset < CHUNK_SIZE) ? len - offset : CHUNK_SIZE;
+         if (!blob.write(std::span<const std::byte>((const std::byte*)bytes + offset, n)))
+            return fail();
+      }
+      return true;
+   }, nullptr);
+}
+
+
+std::string gamzia::BlobStore::put(const std::string& data)
+{
+   return put(data.data(), data.size());
+}
+
+
+/// <summary>
+/// Stores a file without loading it into memory.  The file is hashed first;
+/// if the digest is already stored nothing is written.  Otherwise it is
+/// streamed into the blob and hashed again on the way, so a file that
+/// changes mid-copy is rejected rather than stored under the wrong key.
+/// </summary>
+/// <param name="path">The file to store.</param>
+/// <returns>The hex digest, or an empty string on failure.</returns>
+std::string gamzia::BlobStore::putFile(std::string path)
+{
+   SHA256Digest digest;
+   long long size;
+   std::string hex;
+
+   hex = sha256File(path);
+   if (hex.empty() || !parseDigest(hex, digest))
+   {
+      myerror = "Unable to read " + path;
+      return "";
+   }
+
+   std::ifstream in(path, std::ios::in | std::ios::binary | std::ios::ate);
+   if (!in)
+   {
+      myerror = "Unable to open " + path;
+      return "";
+   }
+   size = (long long)in.tellg();
+   in.seekg(0);
+
+   return insert(digest, size, [this, &in, size, &digest](BlobStream& blob)
+   {
+      std::vector<char> buffer(CHUNK_SIZE);
+      SHA256Digest check;
+      SHA256 ctx = SHA256();
+      long long offset = 0;
+
+      ctx.init();
+      while (offset < size)
+      {
+         size_t n = (size - offset < (long long)CHUNK_SIZE) ? (size_t)(size - offset) : CHUNK_SIZE;
+         in.read(buffer.data(), (std::streamsize)n);
+         if ((size_t)in.gcount() != n)
+         {
+            myerror = "File changed while it was being stored";
+            return false;
+         }
+         ctx.update((const unsigned char*)buffer.data(), n);
+         if (!blob.write(std::as_bytes(std::span<const char>(buffer.data(), n))))
+            return fail();
+         offset += (long long)n;
+      }
+      ctx.final(check.data());
+      if (check != digest)
+      {
+         myerror = "File changed while it was being stored";
+         return false;
+      }
+      return true;
+   }, nullptr);
+}
+
+
+/// <summary>
+/// Streams a blob's content to sink in CHUNK_SIZE pieces.  The sink may
+/// return false to stop early.
+/// </summary>
+/// <param name="digest">The hex digest.</param>
+/// <param name="sink">Receives each chunk.</param>
+/// <returns>True if the blob was found and fully delivered.</returns>
+bool gamzia::BlobStore::read(std::string digest, std::function<bool(const unsigned char*, size_t)> sink)
+{
+   BlobStream blob = open(digest);
+
+   if (!blob.isOpen())
+      return (getSize(digest) == 0);
+
+   return blob.forEachChunk([&sink](std::span<const std::byte> chunk)
+   {
+      return sink((const unsigned char*)chunk.data(), chunk.size());
+   }, CHUNK_SIZE);
+}
+
+
+/// <summary>
+/// Opens a blob's content as a read-only stream, for seeking and ranged
+/// reads without loading it.  Not open if the digest is unknown, and for
+/// empty blobs (nothing to read).
+/// </summary>
+/// <param name="digest">The hex digest.</param>
+/// <returns>The stream; check isOpen().</returns>
+gamzia::BlobStream gamzia::BlobStore::open(std::string digest)
+{
+   SHA256Digest key;
+   long long rowid, size, refs;
+
+   if (!isReadyFlag || !parseDigest(digest, key) || !find(key, rowid, size, refs) || size == 0)
+      return (BlobStream());
+
+   BlobStream blob = BlobStream(mydb, mytable, "data", rowid);
+   if (!blob.isOpen())
+      fail();
+   return (blob);
+}
+
+
+/// <summary>
+/// Loads a blob's content into memory.
+/// </summary>
+/// <param name="digest">The hex digest.</param>
+/// <param name="data">Receives the content.</param>
+/// <returns>True if found.</returns>
+bool gamzia::BlobStore::get(std::string digest, std::vector<unsigned char>& data)
+{
+   long long size = getSize(digest);
+
+   data.clear();
+   if (size < 0)
+      return false;
+
+   data.reserve((size_t)size);
+   return read(digest, [&data](const unsigned char* chunk, size_t len)
+   {
+      data.insert(data.end(), chunk, chunk + len);
+      return true;
+   });
+}
+
+
+bool gamzia::BlobStore::contains(std::string digest)
+{
+   return (getSize(digest) >= 0);
+}
+
+
+/// <summary>
+/// Returns the blob's size in bytes, or -1 if it is not stored.
+/// </summary>
+long long gamzia::BlobStore::getSize(std::string digest)
+{
+   SHA256Digest key;
+   long long rowid, size, refs;
+
+   if (!isReadyFlag || !parseDigest(digest, key) || !find(key, rowid, size, refs))
+      return -1;
+   return (size);
+}
+
+
+/// <summary>
+/// Returns the blob's reference count, or -1 if it is not stored.
+/// </summary>
+long long gamzia::BlobStore::getRefCount(std::string digest)
+{
+   SHA256Digest key;
+   long long rowid, size, refs;
+
+   if (!isReadyFlag || !parseDigest(digest, key) || !find(key, rowid, size, refs))
+      return -1;
+   return (refs);
+}
+
+
+/// <summary>
+/// Adds a reference to a stored blob.
+/// </summary>
+/// <returns>True on success; false if the blob is not stored.</returns>
+bool gamzia::BlobStore::addRef(std::string digest)
+{
+   SHA256Digest key;
+   long long rowid, size, refs;
+
+   if (!isReadyFlag || !parseDigest(digest, key) || !find(key, rowid, size, refs))
+      return false;
+   return bumpRef(rowid, 1);
+}
+
+
+/// <summary>
+/// Drops a reference.  The blob stays stored (and can be revived with
+/// put() or addRef()) until collectGarbage() runs.
+/// </summary>
+/// <returns>True on success; false if the blob is not stored.</returns>
+bool gamzia::BlobStore::release(std::string digest)
+{
+   SHA256Digest key;
+   long long rowid, size, refs;
+
+   if (!isReadyFlag || !parseDigest(digest, key) || !find(key, rowid, size, refs))
+      return false;
+   return bumpRef(rowid, -1);
+}
+
+
+/// <summary>
+/// Deletes every unreferenced blob.
+/// </summary>
+/// <returns>The number of blobs deleted, or -1 on error.</returns>
+long long gamzia::BlobStore::collectGarbage()
+{
+   int rc;
+   long long deleted;
+
+   if (!isReadyFlag)
+      return -1;
+
+   rc = sqlite3_step(mygc);
+   sqlite3_reset(mygc);
+   if (rc != SQLITE_DONE)
+   {
+      fail();
+      return -1;
+   }
+   deleted = sqlite3_changes(mydb);
+   myconnection.flushChanges();
+   return (deleted);
+}
+
+
+/// <summary>
+/// Converts a 64 character hex digest (either case) to raw bytes.
+/// </summary>
+bool gamzia::BlobStore::parseDigest(const std::string& hex, SHA256Digest& digest)
+{
+   if (hex.size() != 2 * digest.size())
+      return false;
+
+   for (size_t i = 0; i < hex.size(); i++)
+   {
+      int c = tolower((unsigned char)hex[i]);
+      int v;
+      if (c >= '0' && c <= '9')
+         v = c - '0';
+      else if (c >= 'a' && c <= 'f')
+         v = c - 'a' + 10;
+      else
+         return false;
+
+      if (i % 2 == 0)
+         digest[i / 2] = (uint8_t)(v << 4);
+      else
+         digest[i / 2] |= (uint8_t)v;
+   }
+   return true;
+}
+
+
+std::string gamzia::BlobStore::toHex(const SHA256Digest& digest)
+{
+   std::string hex(2 * SHA256::DIGEST_SIZE, '0');
+   sha256ToHex(digest, hex.data());
+   return (hex);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include "Sqlite.h"
+#include "SHA256.h"
+
+namespace gamzia
+{
+
+   class BlobStore
+   {
+   public:
+      BlobStore(Sqlite& db);
+      BlobStore(Sqlite& db, std::string table);
+      ~BlobStore();
+      BlobStore(const BlobStore&) = delete;
+      BlobStore& operator=(const BlobStore&) = delete;
+
+      bool isReady();
+      std::string put(const void* data, size_t len);
+      std::string put(const std::string& data);
+      std::string putFile(std::string path);
+      bool get(std::string digest, std::vector<unsigned char>& data);
+      bool read(std::string digest, std::function<bool(const unsigned char*, size_t)> sink);
+      BlobStream open(std::string digest);
+      bool contains(std::string digest);
+      long long getSize(std::string digest);
+      long long getRefCount(std::string digest);
+      bool addRef(std::string digest);
+      bool release(std::string digest);
+      long long collectGarbage();
+      std::string getLastError();
+
+      inline static const std::string TABLENAME = "blobstore";
+      inline static const size_t CHUNK_SIZE = 1 << 20;
+
+   private:
+      Sqlite&       myconnection;       // for change notifications
+      sqlite3*      mydb;
+      std::string   mytable;
+      bool          isReadyFlag;
+      std::string   myerror;
+      sqlite3_stmt* myfind;
+      sqlite3_stmt* myinsert;
+      sqlite3_stmt* myupdate;
+      sqlite3_stmt* mygc;
+
+      bool setup();
+      bool prepare(const std::string& sql, sqlite3_stmt** statement);
+      bool exec(const char* sql);
+      bool fail();
+      bool find(const SHA256Digest& digest, long long& rowid, long long& size, long long& refs);
+      bool bumpRef(long long rowid, int delta);
+      std::string insert(const SHA256Digest& digest, long long size,
+         std::function<bool(BlobStream&)> writer, const void* inlineData);
+      static bool parseDigest(const std::string& hex, SHA256Digest& digest);
+      static std::string toHex(const SHA256Digest& digest);
+   }; // class
+
+}; // namespace
@@ -0,0 +1,352 @@
+/*
+* Class BlobStream
+* ================
+*
+* Streaming access to large BLOB values through SQLite's incremental blob
+* I/O, so a payload of tens of MB is read or written a piece at a time
+* instead of being copied whole into a std::string (or twice, through a
+* stringstream).
+*
+* A BlobStream is opened on one value (table, column, rowid) and has a
+* position, like a file: read() and write() work from it, seek() moves it,
+* readAt() reads at an offset without moving it.  forEachChunk() hands the
+* value out as spans of CHUNK_SIZE bytes.  reopen() moves the handle to
+* another row of the same column, which is much cheaper than a new open.
+*
+* Blob I/O can not resize a value: write into space reserved beforehand
+* with zeroblob(n).  If the row is changed or deleted by another statement
+* while the stream is open, the handle expires and further calls fail.
+*
+* BlobStreamBuf adapts a BlobStream to std::streambuf, for std::istream and
+* std::ostream users.
+*
+-->
+gamzia::Cursor k = db.getCursor();
+k.execute("INSERT INTO files (name, data) VALUES (?, zeroblob(?))", { name, std::to_string(size) });
+
+gamzia::BlobStream out = k.openBlob("files", "data", rowid, true);
+out.write(std::as_bytes(std::span(header)));
+out.write(std::as_bytes(std::span(body)));
+
+gamzia::BlobStream in = k.openBlob("files", "data", rowid);
+in.seek(1024);
+gamzia::BlobStreamBuf buffer = gamzia::BlobStreamBuf(in);
+std::istream text(&buffer);
+std::getline(text, line);
+<--
+*/
+
+#include "BlobStream.h"
+#include <algorithm>
+
+
+/*********************
+*  Class BlobStream  *
+*********************/
+
+/// <summary>
+/// A closed stream; every operation fails.
+/// </summary>
+gamzia::BlobStream::BlobStream()
+{
+   mydb = nullptr;
+   myblob = nullptr;
+   mysize = 0;
+   myposition = 0;
+}
+
+/// <summary>
+/// Opens a BLOB value for incremental I/O.  Check isOpen().
+/// </summary>
+/// <param name="db">The connection.</param>
+/// <param name="table">The table.</param>
+/// <param name="column">The BLOB (or TEXT) column.</param>
+/// <param name="rowid">The row.</param>
+/// <param name="writable">Open for writing as well as reading.</param>
+/// <param name="database">"main", "temp" or an attached database.</param>
+gamzia::BlobStream::BlobStream(sqlite3* db, const std::string& table, const std::string& column, int64_t rowid,
+   bool writable, const std::string& database)
+{
+   mydb = db;
+   myblob = nullptr;
+   mysize = 0;
+   myposition = 0;
+
+   if (mydb == nullptr)
+   {
+      myerror = "Database not connected";
+      return;
+   }
+   int rc = sqlite3_blob_open(mydb, database.c_str(), table.c_str(), column.c_str(), rowid, writable ? 1 : 0, &myblob);
+   if (rc != SQLITE_OK)
+   {
+      fail(rc);
+      sqlite3_blob_close(myblob);
+      myblob = nullptr;
+      return;
+   }
+   mysize = sqlite3_blob_bytes(myblob);
+}
+
+gamzia::BlobStream::~BlobStream()
+{
+   close();
+}
+
+gamzia::BlobStream::BlobStream(BlobStream&& other) noexcept
+{
+   mydb = other.mydb;
+   myblob = other.myblob;
+   mysize = other.mysize;
+   myposition = other.myposition;
+   myerror = std::move(other.myerror);
+   other.myblob = nullptr;
+}
+
+gamzia::BlobStream& gamzia::BlobStream::operator=(BlobStream&& other) noexcept
+{
+   if (this != &other)
+   {
+      close();
+      mydb = other.mydb;
+      myblob = other.myblob;
+      mysize = other.mysize;
+      myposition = other.myposition;
+      myerror = std::move(other.myerror);
+      other.myblob = nullptr;
+   }
+   return (*this);
+}
+
+bool gamzia::BlobStream::isOpen() const
+{
+   return (myblob != nullptr);
+}
+
+int64_t gamzia::BlobStream::getSize() const
+{
+   return (mysize);
+}
+
+int64_t gamzia::BlobStream::tell() const
+{
+   return (myposition);
+}
+
+/// <summary>
+/// Moves the position; anywhere from 0 to getSize().
+/// </summary>
+bool gamzia::BlobStream::seek(int64_t offset)
+{
+   if (myblob == nullptr || offset < 0 || offset > mysize)
+      return false;
+   myposition = offset;
+   return true;
+}
+
+/// <summary>
+/// Reads up to buffer.size() bytes from the position, and advances it.
+/// </summary>
+/// <returns>Bytes read; 0 at the end or on error.</returns>
+size_t gamzia::BlobStream::read(std::span<std::byte> buffer)
+{
+   size_t n = (size_t)std::min<int64_t>((int64_t)buffer.size(), mysize - myposition);
+
+   if (myblob == nullptr || n == 0)
+      return (0);
+   if (!readAt(myposition, buffer.first(n)))
+      return (0);
+   myposition += (int64_t)n;
+   return (n);
+}
+
+/// <summary>
+/// Reads exactly buffer.size() bytes at offset; the position is unchanged.
+/// </summary>
+/// <returns>False if the range is outside the value, or on error.</returns>
+bool gamzia::BlobStream::readAt(int64_t offset, std::span<std::byte> buffer)
+{
+   if (myblob == nullptr || offset < 0 || offset + (int64_t)buffer.size() > mysize)
+      return false;
+   if (buffer.empty())
+      return true;
+   return (fail(sqlite3_blob_read(myblob, buffer.data(), (int)buffer.size(), (int)offset)));
+}
+
+/// <summary>
+/// Writes data at the position and advances it.  The value can not grow:
+/// writing past getSize() fails and writes nothing.
+/// </summary>
+bool gamzia::BlobStream::write(std::span<const std::byte> data)
+{
+   if (myblob == nullptr || myposition + (int64_t)data.size() > mysize)
+   {
+      myerror = (myblob == nullptr ? "Blob not open" : "Write past the end of the blob");
+      return false;
+   }
+   if (data.empty())
+      return true;
+   if (!fail(sqlite3_blob_write(myblob, data.data(), (int)data.size(), (int)myposition)))
+      return false;
+   myposition += (int64_t)data.size();
+   return true;
+}
+
+/// <summary>
+/// Hands the rest of the value, from the position, to sink in chunks of
+/// chunkSize bytes (one reused buffer).  The sink may return false to stop.
+/// </summary>
+/// <returns>True if everything was delivered.</returns>
+bool gamzia::BlobStream::forEachChunk(std::function<bool(std::span<const std::byte>)> sink, size_t chunkSize)
+{
+   std::vector<std::byte> buffer((size_t)std::min<int64_t>((int64_t)std::max(chunkSize, (size_t)1), mysize - myposition));
+
+   if (myblob == nullptr)
+      return false;
+   while (myposition < mysize)
+   {
+      size_t n = read(buffer);
+      if (n == 0 || !sink(std::span<const std::byte>(buffer.data(), n)))
+         return false;
+   }
+   return true;
+}
+
+/// <summary>
+/// Points the stream at another row of the same table and column, and
+/// rewinds it.
+/// </summary>
+bool gamzia::BlobStream::reopen(int64_t rowid)
+{
+   if (myblob == nullptr)
+      return false;
+
+   int rc = sqlite3_blob_reopen(myblob, rowid);
+   if (rc != SQLITE_OK)
+   {
+      // The handle is unusable after a failed reopen
+      fail(rc);
+      close();
+      return false;
+   }
+   mysize = sqlite3_blob_bytes(myblob);
+   myposition = 0;
+   return true;
+}
+
+void gamzia::BlobStream::close()
+{
+   if (myblob != nullptr)
+      sqlite3_blob_close(myblob);
+   myblob = nullptr;
+   mysize = 0;
+   myposition = 0;
+}
+
+std::string gamzia::BlobStream::getLastError()
+{
+   return (myerror);
+}
+
+/// <summary>
+/// Records SQLite's message if rc is an error.
+/// </summary>
+/// <returns>True if rc is SQLITE_OK.</returns>
+bool gamzia::BlobStream::fail(int rc)
+{
+   if (rc == SQLITE_OK)
+      return true;
+   myerror = (mydb != nullptr ? sqlite3_errmsg(mydb) : sqlite3_errstr(rc));
+   return false;
+}
+
+/************************
+*  Class BlobStreamBuf  *
+************************/
+
+/// <summary>
+/// Constructor.  Reading and writing start at the stream's position.
+/// </summary>
+/// <param name="stream">An open BlobStream.</param>
+/// <param name="bufferSize">Bytes buffered per blob read or write.</param>
+gamzia::BlobStreamBuf::BlobStreamBuf(BlobStream& stream, size_t bufferSize)
+   : mystream(stream), mybuffer(std::max(bufferSize, (size_t)1))
+{
+}
+
+/// <summary>
+/// Writes out anything still buffered.
+/// </summary>
+gamzia::BlobStreamBuf::~BlobStreamBuf()
+{
+   sync();
+}
+
+gamzia::BlobStreamBuf::int_type gamzia::BlobStreamBuf::underflow()
+{
+   if (sync() != 0)
+      return (traits_type::eof());
+
+   size_t n = mystream.read(std::as_writable_bytes(std::span<char>(mybuffer)));
+   if (n == 0)
+      return (traits_type::eof());
+   setg(mybuffer.data(), mybuffer.data(), mybuffer.data() + n);
+   return (traits_type::to_int_type(*gptr()));
+}
+
+gamzia::BlobStreamBuf::int_type gamzia::BlobStreamBuf::overflow(int_type c)
+{
+   if (sync() != 0)
+      return (traits_type::eof());
+
+   setp(mybuffer.data(), mybuffer.data() + mybuffer.size());
+   if (!traits_type::eq_int_type(c, traits_type::eof()))
+   {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+   }
+   return (traits_type::not_eof(c));
+}
+
+/// <summary>
+/// Writes the put area out, and gives back the unread part of the get area
+/// (moves the stream's position back over it), so the BlobStream's position
+/// is the logical one again.
+/// </summary>
+int gamzia::BlobStreamBuf::sync()
+{
+   if (pptr() != nullptr && pptr() > pbase())
+   {
+      if (!mystream.write(std::as_bytes(std::span<const char>(pbase(), (size_t)(pptr() - pbase())))))
+         return (-1);
+   }
+   setp(nullptr, nullptr);
+
+   if (gptr() != nullptr && gptr() < egptr())
+      mystream.seek(mystream.tell() - (egptr() - gptr()));
+   setg(nullptr, nullptr, nullptr);
+   return (0);
+}
+
+gamzia::BlobStreamBuf::pos_type gamzia::BlobStreamBuf::seekoff(off_type offset, std::ios_base::seekdir direction,
+   std::ios_base::openmode)
+{
+   int64_t target = offset;
+
+   if (sync() != 0)
+      return (pos_type(off_type(-1)));
+
+   if (direction == std::ios_base::cur)
+      target += mystream.tell();
+   else if (direction == std::ios_base::end)
+      target += mystream.getSize();
+
+   if (!mystream.seek(target))
+      return (pos_type(off_type(-1)));
+   return (pos_type(off_type(target)));
+}
+
+gamzia::BlobStreamBuf::pos_type gamzia::BlobStreamBuf::seekpos(pos_type position, std::ios_base::openmode which)
+{
+   return (seekoff(off_type(position), std::ios_base::beg, which));
+}
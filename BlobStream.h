@@ -0,0 +1,84 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <span>
+#include <streambuf>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include "sqlite3.h"
+
+namespace gamzia
+{
+
+   /// <summary>
+   /// Incremental I/O on one BLOB value (sqlite3_blob), with a position that
+   /// read() and write() advance and seek() moves.  Move-only.  A blob can
+   /// not change size this way: reserve the space first, ie, with
+   /// INSERT ... VALUES (zeroblob(?)).
+   /// </summary>
+   class BlobStream
+   {
+
+   public:
+      BlobStream();
+      BlobStream(sqlite3 *db, const std::string& table, const std::string& column, int64_t rowid,
+         bool writable = false, const std::string& database = "main");
+      ~BlobStream();
+      BlobStream(const BlobStream&) = delete;
+      BlobStream& operator=(const BlobStream&) = delete;
+      BlobStream(BlobStream&& other) noexcept;
+      BlobStream& operator=(BlobStream&& other) noexcept;
+
+      bool isOpen() const;
+      int64_t getSize() const;
+      int64_t tell() const;
+      bool seek(int64_t offset);
+      size_t read(std::span<std::byte> buffer);
+      bool readAt(int64_t offset, std::span<std::byte> buffer);
+      bool write(std::span<const std::byte> data);
+      bool forEachChunk(std::function<bool(std::span<const std::byte>)> sink, size_t chunkSize = CHUNK_SIZE);
+      bool reopen(int64_t rowid);
+      void close();
+      std::string getLastError();
+
+      inline static const size_t CHUNK_SIZE = 1 << 20;
+
+   private:
+      sqlite3      *mydb;
+      sqlite3_blob *myblob;
+      int64_t      mysize;
+      int64_t      myposition;
+      std::string  myerror;
+
+      bool fail(int rc);
+   };
+
+   /// <summary>
+   /// A std::streambuf over a BlobStream, so a blob can be used with
+   /// std::istream / std::ostream (operator&lt;&lt;, getline, seekg, ...).
+   /// The BlobStream must outlive it.  Writes are buffered: call
+   /// pubsync() (or flush the ostream) before using the BlobStream directly.
+   /// </summary>
+   class BlobStreamBuf : public std::streambuf
+   {
+
+   public:
+      BlobStreamBuf(BlobStream& stream, size_t bufferSize = BUFFER_SIZE);
+      ~BlobStreamBuf();
+
+      inline static const size_t BUFFER_SIZE = 64 * 1024;
+
+   protected:
+      int_type underflow() override;
+      int_type overflow(int_type c) override;
+      int sync() override;
+      pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override;
+      pos_type seekpos(pos_type position, std::ios_base::openmode which) override;
+
+   private:
+      BlobStream&       mystream;
+      std::vector<char> mybuffer;
+   };
+
+}; // namespace
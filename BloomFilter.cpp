@@ -0,0 +1,172 @@
+/*
+* Class CountingBloomFilter
+* =========================
+*
+* A set membership test that answers "definitely not" or "maybe", in a few
+* bits per item and a handful of memory reads, for putting in front of a
+* slower lookup (ie, a database query) that mostly misses.
+*
+* Each item sets k counters, picked by k hashes (double hashing of one
+* 64 bit hash).  It is "maybe" present if all k are non-zero.  The counters
+* are 4 bits rather than the classic single bit so remove() can decrement
+* them; one that reaches 15 stays there, which can only cost an extra false
+* positive, never a false negative.  Removing an item that was never added
+* does break that guarantee: only remove what was added.
+*
+* The size is worked out from the capacity and the false positive rate
+* wanted: m = -n ln(p) / ln(2)^2 counters and k = m/n ln(2) hashes, ie,
+* about 9.6 counters, or 4.8 bytes, per item at 1% (four times a plain bit
+* filter).  Past its capacity the filter still works, with more false
+* positives; getStats() estimates the current rate.
+*
+-->
+gamzia::CountingBloomFilter filter = gamzia::CountingBloomFilter(100000, 0.001);
+filter.add("alice");
+if (!filter.mightContain(name))
+   return false;                 // no need to ask the database
+filter.remove("alice");
+<--
+*/
+
+#include "BloomFilter.h"
+#include <cmath>
+#include <algorithm>
+#include <functional>
+
+
+/// <summary>
+/// Constructor.
+/// </summary>
+/// <param name="capacity">Items it should hold at the false positive rate.</param>
+/// <param name="falsePositiveRate">Wanted rate, ie, 0.01 for 1%.</param>
+gamzia::CountingBloomFilter::CountingBloomFilter(size_t capacity, double falsePositiveRate)
+{
+   const double ln2 = std::log(2.0);
+
+   if (!(falsePositiveRate > 0.0 && falsePositiveRate < 1.0))
+      falsePositiveRate = FALSE_POSITIVE_RATE;
+   mycapacity = std::max(capacity, (size_t)1);
+   mysize = std::max((size_t)std::ceil(-(double)mycapacity * std::log(falsePositiveRate) / (ln2 * ln2)), (size_t)64);
+   myhashes = std::clamp((size_t)std::lround((double)mysize / (double)mycapacity * ln2), (size_t)1, MAX_HASHES);
+   mycounters.assign((mysize + 1) / 2, 0);
+   mycount = 0;
+   myqueries = 0;
+   mynegatives = 0;
+}
+
+void gamzia::CountingBloomFilter::add(std::string_view item)
+{
+   size_t slots[MAX_HASHES];
+
+   indexes(item, slots);
+   for (size_t i = 0; i < myhashes; i++)
+   {
+      uint8_t value = get(slots[i]);
+      if (value < COUNTER_MAX)
+         set(slots[i], value + 1);
+   }
+   mycount++;
+}
+
+/// <summary>
+/// Removes an item that was added.  Saturated counters are left alone, as
+/// their true count is unknown.
+/// </summary>
+void gamzia::CountingBloomFilter::remove(std::string_view item)
+{
+   size_t slots[MAX_HASHES];
+
+   indexes(item, slots);
+   for (size_t i = 0; i < myhashes; i++)
+   {
+      uint8_t value = get(slots[i]);
+      if (value > 0 && value < COUNTER_MAX)
+         set(slots[i], value - 1);
+   }
+   if (mycount > 0)
+      mycount--;
+}
+
+/// <summary>
+/// Tests for an item.
+/// </summary>
+/// <returns>False if the item is definitely absent; true if it may be present.</returns>
+bool gamzia::CountingBloomFilter::mightContain(std::string_view item)
+{
+   size_t slots[MAX_HASHES];
+
+   myqueries++;
+   indexes(item, slots);
+   for (size_t i = 0; i < myhashes; i++)
+   {
+      if (get(slots[i]) == 0)
+      {
+         mynegatives++;
+         return false;
+      }
+   }
+   return true;
+}
+
+void gamzia::CountingBloomFilter::clear()
+{
+   std::fill(mycounters.begin(), mycounters.end(), (uint8_t)0);
+   mycount = 0;
+}
+
+size_t gamzia::CountingBloomFilter::getCount() const
+{
+   return (mycount);
+}
+
+size_t gamzia::CountingBloomFilter::getCapacity() const
+{
+   return (mycapacity);
+}
+
+gamzia::BloomFilterStats gamzia::CountingBloomFilter::getStats() const
+{
+   BloomFilterStats stats = BloomFilterStats();
+
+   stats.items = mycount;
+   stats.capacity = mycapacity;
+   stats.bytes = mycounters.size();
+   stats.hashes = myhashes;
+   stats.queries = myqueries;
+   stats.negatives = mynegatives;
+
+   // (1 - e^(-kn/m))^k
+   stats.falsePositiveRate = std::pow(1.0 - std::exp(-(double)myhashes * (double)mycount / (double)mysize),
+      (double)myhashes);
+   return (stats);
+}
+
+/// <summary>
+/// The item's k counters: h1 + i * h2, from one 64 bit hash split in two
+/// (Kirsch-Mitzenmacher double hashing).
+/// </summary>
+void gamzia::CountingBloomFilter::indexes(std::string_view item, size_t* slots) const
+{
+   uint64_t h1 = (uint64_t)std::hash<std::string_view>{}(item);
+
+   // splitmix64 finalizer, for a second hash that is independent enough
+   uint64_t h2 = h1 + 0x9E3779B97F4A7C15ULL;
+   h2 = (h2 ^ (h2 >> 30)) * 0xBF58476D1CE4E5B9ULL;
+   h2 = (h2 ^ (h2 >> 27)) * 0x94D049BB133111EBULL;
+   h2 = (h2 ^ (h2 >> 31)) | 1;
+
+   for (size_t i = 0; i < myhashes; i++)
+      slots[i] = (size_t)((h1 + i * h2) % mysize);
+}
+
+uint8_t gamzia::CountingBloomFilter::get(size_t slot) const
+{
+   return ((mycounters[slot >> 1] >> ((slot & 1) * 4)) & 0x0F);
+}
+
+void gamzia::CountingBloomFilter::set(size_t slot, uint8_t value)
+{
+   uint8_t& pair = mycounters[slot >> 1];
+   unsigned shift = (unsigned)(slot & 1) * 4;
+   pair = (uint8_t)((pair & ~(0x0F << shift)) | ((value & 0x0F) << shift));
+}
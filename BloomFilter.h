@@ -0,0 +1,60 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace gamzia
+{
+
+   struct BloomFilterStats
+   {
+      unsigned long long items;           // added less removed
+      unsigned long long capacity;        // items it was sized for
+      unsigned long long bytes;
+      unsigned long long hashes;          // counters per item
+      unsigned long long queries;
+      unsigned long long negatives;       // queries answered "definitely not"
+      double falsePositiveRate;           // estimated, at the current load
+   };
+
+   /// <summary>
+   /// A counting Bloom filter of strings: 4 bit counters instead of bits, so
+   /// items can be removed as well as added.  mightContain() has no false
+   /// negatives, and false positives at about the rate it was sized for,
+   /// as long as it holds no more than its capacity.  Not thread safe.
+   /// </summary>
+   class CountingBloomFilter
+   {
+
+   public:
+      CountingBloomFilter(size_t capacity = 1024, double falsePositiveRate = FALSE_POSITIVE_RATE);
+
+      void add(std::string_view item);
+      void remove(std::string_view item);
+      bool mightContain(std::string_view item);
+      void clear();
+      size_t getCount() const;
+      size_t getCapacity() const;
+      BloomFilterStats getStats() const;
+
+      inline static const double FALSE_POSITIVE_RATE = 0.01;
+      inline static const size_t MAX_HASHES = 16;
+
+   private:
+      std::vector<uint8_t> mycounters;    // two per byte
+      size_t mysize;                      // counters
+      size_t myhashes;
+      size_t mycount;
+      size_t mycapacity;
+      unsigned long long myqueries;
+      unsigned long long mynegatives;
+
+      inline static const uint8_t COUNTER_MAX = 15;
+
+      void indexes(std::string_view item, size_t* slots) const;
+      uint8_t get(size_t slot) const;
+      void set(size_t slot, uint8_t value);
+   }; // class
+
+}; // namespace
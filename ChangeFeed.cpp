@@ -0,0 +1,217 @@
+/*
+* Class ChangeFeed
+* ================
+*
+* Row change notifications for a Sqlite connection, batched per committed
+* transaction, for keeping application caches coherent.
+*
+* SQLite's update hook reports each inserted, updated or deleted rowid as it
+* happens; the feed collects them for the current transaction.  A rollback
+* discards the collection.  A commit hands it to the subscribers as one
+* ChangeBatch, and only after the commit has actually completed, so a cache
+* that drops the listed rows can not be refilled with the old values by a
+* reader that raced the commit.
+*
+* Every connection has a feed from connect() on, shared by all its cursors,
+* but the hooks only go in with the first subscriber.  Batches are delivered
+* on the thread that committed, from the Cursor call that finished the
+* transaction (or from Sqlite::flushChanges(), for commits made through the
+* raw handle).  Keep listeners short, and do not use the
+* connection from inside one.
+*
+* A DELETE with no WHERE clause normally clears a table without per row
+* events (SQLite's truncate optimization).  The feed's authorizer turns that
+* optimization off for the watched tables, so such a DELETE reports every
+* row like any other; this is also why statements are prepared again after
+* subscribe().
+*
+* Limits, from SQLite: WITHOUT ROWID tables are not reported, and changes
+* rolled back to a savepoint are still reported at commit (so a listener may
+* invalidate a little more than changed, never less).
+*
+-->
+int id = db.subscribe([&](const gamzia::ChangeBatch& batch)
+{
+   for (const gamzia::ChangeEvent& e : batch.events)
+      cache.invalidate(e.rowid);
+}, "accounts");
+<--
+*/
+
+#include "ChangeFeed.h"
+#include <algorithm>
+
+
+/// <summary>
+/// Constructor.  Nothing is installed on db until the first subscribe(),
+/// so a connection nobody watches pays nothing for its feed.
+/// </summary>
+/// <param name="db">The connection to watch.</param>
+gamzia::ChangeFeed::ChangeFeed(sqlite3* db)
+{
+   mydb = db;
+   mynextid = 1;
+   mypending = ChangeBatch();
+   isCommittingFlag = false;
+   mysequence = 0;
+}
+
+/// <summary>
+/// Adds a listener.  The first one installs the update, commit and
+/// rollback hooks and the authorizer, replacing any others.
+/// </summary>
+/// <param name="listener">Called with each committed batch.</param>
+/// <param name="table">Only batches touching this table, with only its
+/// events; empty for everything.</param>
+/// <returns>An id for unsubscribe().</returns>
+int gamzia::ChangeFeed::subscribe(ChangeListener listener, std::string table)
+{
+   int id;
+   {
+      std::lock_guard<std::mutex> guard(mylock);
+      id = mynextid++;
+      mylisteners[id] = Subscription{ std::move(listener), std::move(table) };
+   }
+   watch();
+   return (id);
+}
+
+bool gamzia::ChangeFeed::unsubscribe(int id)
+{
+   std::lock_guard<std::mutex> guard(mylock);
+   return (mylisteners.erase(id) > 0);
+}
+
+/// <summary>
+/// Hands the committed batch to the listeners, if a COMMIT ran and the
+/// transaction is over.  A COMMIT that failed with SQLITE_BUSY leaves the
+/// transaction open: the batch waits for the retry.
+/// </summary>
+void gamzia::ChangeFeed::deliver()
+{
+   std::vector<Subscription> listeners;
+
+   if (!isCommittingFlag || mydb == nullptr || sqlite3_get_autocommit(mydb) == 0)
+      return;
+
+   ChangeBatch batch = std::move(mypending);
+   mypending = ChangeBatch();
+   isCommittingFlag = false;
+   if (batch.tables.empty())
+      return;
+   batch.sequence = ++mysequence;
+
+   // Listeners are called outside the lock; they may (un)subscribe
+   {
+      std::lock_guard<std::mutex> guard(mylock);
+      for (const auto& entry : mylisteners)
+         listeners.push_back(entry.second);
+   }
+
+   for (const Subscription& s : listeners)
+   {
+      if (s.table.empty())
+      {
+         s.listener(batch);
+         continue;
+      }
+      if (std::find(batch.tables.begin(), batch.tables.end(), s.table) == batch.tables.end())
+         continue;
+
+      ChangeBatch filtered = ChangeBatch();
+      filtered.sequence = batch.sequence;
+      filtered.tables.push_back(s.table);
+      filtered.isTruncated = batch.isTruncated;
+      for (const ChangeEvent& e : batch.events)
+      {
+         if (e.table == s.table)
+            filtered.events.push_back(e);
+      }
+      s.listener(filtered);
+   }
+}
+
+/// <summary>
+/// Removes the hooks; called by Sqlite before the connection closes.
+/// </summary>
+void gamzia::ChangeFeed::detach()
+{
+   if (mydb == nullptr)
+      return;
+   sqlite3_update_hook(mydb, NULL, NULL);
+   sqlite3_commit_hook(mydb, NULL, NULL);
+   sqlite3_rollback_hook(mydb, NULL, NULL);
+   sqlite3_set_authorizer(mydb, NULL, NULL);
+   mydb = nullptr;
+}
+
+void gamzia::ChangeFeed::onUpdate(void* data, int operation, const char*, const char* table, sqlite3_int64 rowid)
+{
+   ChangeBatch& pending = ((ChangeFeed*)data)->mypending;
+
+   // Usually the same table as the last event
+   if (pending.tables.empty() || pending.tables.back() != table)
+   {
+      if (std::find(pending.tables.begin(), pending.tables.end(), table) == pending.tables.end())
+         pending.tables.push_back(table);
+   }
+
+   if (pending.events.size() >= MAX_EVENTS)
+   {
+      pending.isTruncated = true;
+      return;
+   }
+   pending.events.push_back(ChangeEvent{ operation, table, (int64_t)rowid });
+}
+
+int gamzia::ChangeFeed::onCommit(void* data)
+{
+   // Not committed yet: deliver() checks the transaction really ended
+   ((ChangeFeed*)data)->isCommittingFlag = true;
+   return (0);
+}
+
+void gamzia::ChangeFeed::onRollback(void* data)
+{
+   ChangeFeed* feed = (ChangeFeed*)data;
+   feed->mypending = ChangeBatch();
+   feed->isCommittingFlag = false;
+}
+
+/// <summary>
+/// Authorizer: answers SQLITE_IGNORE to the DELETE of a watched table.  For
+/// a DELETE that only disables the truncate optimization - every row is
+/// still deleted, one by one, through the update hook.
+/// </summary>
+int gamzia::ChangeFeed::onAuthorize(void* data, int action, const char* table, const char*, const char*, const char*)
+{
+   ChangeFeed* feed = (ChangeFeed*)data;
+
+   if (action != SQLITE_DELETE || table == nullptr)
+      return (SQLITE_OK);
+
+   std::lock_guard<std::mutex> guard(feed->mylock);
+   for (const auto& entry : feed->mylisteners)
+   {
+      if (entry.second.table.empty() || entry.second.table == table)
+         return (SQLITE_IGNORE);
+   }
+   return (SQLITE_OK);
+}
+
+/// <summary>
+/// (Re)installs the hooks and the authorizer.  SQLite expires every
+/// prepared statement when the authorizer is set, so cached DELETEs are
+/// prepared again under the new set of watched tables.  Called without
+/// mylock: preparing takes the connection's mutex and then mylock, in that
+/// order.
+/// </summary>
+void gamzia::ChangeFeed::watch()
+{
+   if (mydb == nullptr)
+      return;
+   sqlite3_update_hook(mydb, &ChangeFeed::onUpdate, this);
+   sqlite3_commit_hook(mydb, &ChangeFeed::onCommit, this);
+   sqlite3_rollback_hook(mydb, &ChangeFeed::onRollback, this);
+   sqlite3_set_authorizer(mydb, &ChangeFeed::onAuthorize, this);
+}
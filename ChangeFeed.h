@@ -0,0 +1,82 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+#include "sqlite3.h"
+
+namespace gamzia
+{
+
+   struct ChangeEvent
+   {
+      int operation;                      // SQLITE_INSERT, SQLITE_UPDATE or SQLITE_DELETE
+      std::string table;
+      int64_t rowid;
+   };
+
+   /// <summary>
+   /// The row changes of one committed transaction.  tables lists every
+   /// table touched; when isTruncated is set there were more than
+   /// ChangeFeed::MAX_EVENTS changes and only the first ones are in events,
+   /// so treat the listed tables as wholly changed.
+   /// </summary>
+   struct ChangeBatch
+   {
+      unsigned long long sequence;
+      std::vector<ChangeEvent> events;
+      std::vector<std::string> tables;
+      bool isTruncated;
+   };
+
+   typedef std::function<void(const ChangeBatch&)> ChangeListener;
+
+   class ChangeFeed
+   {
+
+   public:
+      ChangeFeed(sqlite3 *db);
+      ChangeFeed(const ChangeFeed&) = delete;
+      ChangeFeed& operator=(const ChangeFeed&) = delete;
+
+      int subscribe(ChangeListener listener, std::string table = "");
+      bool unsubscribe(int id);
+      void deliver();
+      void detach();
+
+      /// <summary>
+      /// True once a COMMIT has started; deliver() then hands the batch
+      /// out if the transaction did end.  Checked after every step.
+      /// </summary>
+      bool isCommitting() const
+      {
+         return (isCommittingFlag);
+      }
+
+      inline static const size_t MAX_EVENTS = 100000;
+
+   private:
+      struct Subscription
+      {
+         ChangeListener listener;
+         std::string table;
+      };
+
+      sqlite3 *mydb;
+      std::mutex mylock;                  // mylisteners, mynextid; never held into SQLite
+      std::map<int, Subscription> mylisteners;
+      int mynextid;
+      ChangeBatch mypending;              // connection thread only
+      bool isCommittingFlag;
+      unsigned long long mysequence;
+
+      static void onUpdate(void *data, int operation, const char *database, const char *table, sqlite3_int64 rowid);
+      static int onCommit(void *data);
+      static int onAuthorize(void *data, int action, const char *table, const char *, const char *, const char *);
+      static void onRollback(void *data);
+      void watch();
+   }; // class
+
+}; // namespace
@@ -0,0 +1,381 @@
+/*
+* Class ConnectionPool
+* ====================
+*
+* A thread safe pool of Sqlite connections to one database file, for
+* multi-threaded servers.
+*
+* A single Sqlite object is one sqlite3 connection and must not be shared
+* between threads without a lock around it.  The pool instead opens one
+* writer connection and N reader connections, puts the database in WAL mode
+* (so readers never block the writer or each other), and sets a busy timeout
+* on each.  Threads lease a connection for the duration of a request (or for
+* their lifetime) and the lease hands it back when it goes out of scope.
+*
+* SQLite allows one writer at a time regardless, so the writer is a single
+* connection: writers queue here, in the process, rather than spinning on
+* SQLITE_BUSY.  Readers only wait when all N are leased.
+*
+* Wait times and saturation (the share of acquisitions that had to wait) are
+* kept in getStats(); a saturation near 1 means more readers are needed.
+*
+* NOTE: WAL needs a file database; ":memory:" cannot be pooled.
+*
+-->
+gamzia::ConnectionPool pool = gamzia::ConnectionPool("accounts.db", 8);
+
+// Any number of threads:
+{
+   gamzia::ConnectionLease lease = pool.acquireReader();
+   if (lease.isValid())
+   {
+      gamzia::Cursor k = lease.getCursor();
+      k.execute("SELECT password FROM accounts WHERE user=?", params);
+      row = k.fetchOne();
+   }
+}  // returned to the pool here
+
+{
+   gamzia::ConnectionLease lease = pool.acquireWriter();
+   lease.getCursor().execute("UPDATE accounts SET password=? WHERE user=?", params);
+}
+<--
+*/
+
+#include "ConnectionPool.h"
+#include <algorithm>
+
+
+/**************************
+*  Class ConnectionLease  *
+**************************/
+
+gamzia::ConnectionLease::ConnectionLease()
+{
+   mypool = nullptr;
+   myconnection = nullptr;
+   isWriterFlag = false;
+}
+
+gamzia::ConnectionLease::ConnectionLease(ConnectionPool* pool, Sqlite* connection, bool writer)
+{
+   mypool = pool;
+   myconnection = connection;
+   isWriterFlag = writer;
+}
+
+gamzia::ConnectionLease::~ConnectionLease()
+{
+   release();
+}
+
+gamzia::ConnectionLease::ConnectionLease(ConnectionLease&& other) noexcept
+{
+   mypool = other.mypool;
+   myconnection = other.myconnection;
+   isWriterFlag = other.isWriterFlag;
+   other.mypool = nullptr;
+   other.myconnection = nullptr;
+}
+
+gamzia::ConnectionLease& gamzia::ConnectionLease::operator=(ConnectionLease&& other) noexcept
+{
+   if (this != &other)
+   {
+      release();
+      mypool = other.mypool;
+      myconnection = other.myconnection;
+      isWriterFlag = other.isWriterFlag;
+      other.mypool = nullptr;
+      other.myconnection = nullptr;
+   }
+   return (*this);
+}
+
+/// <summary>
+/// False if the acquisition timed out or the pool is not ready.
+/// </summary>
+bool gamzia::ConnectionLease::isValid() const
+{
+   return (myconnection != nullptr);
+}
+
+bool gamzia::ConnectionLease::isWriter() const
+{
+   return (isWriterFlag);
+}
+
+gamzia::Sqlite& gamzia::ConnectionLease::get()
+{
+   return (*myconnection);
+}
+
+gamzia::Sqlite* gamzia::ConnectionLease::operator->()
+{
+   return (myconnection);
+}
+
+/// <summary>
+/// A cursor on the leased connection.  Let it go before the lease does.
+/// </summary>
+gamzia::Cursor gamzia::ConnectionLease::getCursor()
+{
+   return (myconnection->getCursor());
+}
+
+/// <summary>
+/// Hands the connection back early.  Any transaction left open on it is
+/// rolled back first, so the next holder starts clean.
+/// </summary>
+void gamzia::ConnectionLease::release()
+{
+   if (mypool == nullptr || myconnection == nullptr)
+      return;
+
+   mypool->release(myconnection, isWriterFlag);
+   mypool = nullptr;
+   myconnection = nullptr;
+}
+
+/*************************
+*  Class ConnectionPool  *
+*************************/
+
+/// <summary>
+/// Constructor; DEFAULT_READERS readers and the default busy timeout.
+/// </summary>
+/// <param name="dbname">The database file.  Created if needed.</param>
+gamzia::ConnectionPool::ConnectionPool(std::string dbname)
+   : ConnectionPool(dbname, DEFAULT_READERS, BUSY_TIMEOUT)
+{
+}
+
+/// <summary>
+/// Opens the writer (creating the file if needed), switches the database
+/// to WAL, then opens the read-only readers.  Check isReady().
+/// </summary>
+/// <param name="dbname">The database file.</param>
+/// <param name="readers">Number of reader connections (at least 1).</param>
+/// <param name="busyTimeout">SQLite busy timeout per connection, in ms.</param>
+gamzia::ConnectionPool::ConnectionPool(std::string dbname, size_t readers, int busyTimeout)
+{
+   mydbname = dbname;
+   isReadyFlag = false;
+   isWriterFree = true;
+   mystats = ConnectionPoolStats();
+   readers = std::max(readers, (size_t)1);
+
+   // NOMUTEX: a leased connection is only used by one thread at a time,
+   // so SQLite's per-connection mutex is redundant
+   mywriter = std::make_unique<Sqlite>(dbname);
+   if (!open(*mywriter, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, busyTimeout))
+      return;
+   if (!mywriter->setJournalMode("WAL"))
+   {
+      myerror = "WAL journal mode unavailable for " + dbname;
+      return;
+   }
+
+   for (size_t i = 0; i < readers; i++)
+   {
+      myreaders.push_back(std::make_unique<Sqlite>(dbname));
+      if (!open(*myreaders.back(), SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, busyTimeout))
+         return;
+      myfreereaders.push_back(myreaders.back().get());
+   }
+
+   mystats.readers = readers;
+   isReadyFlag = true;
+}
+
+/// <summary>
+/// Closes every connection.  All leases must have been returned.
+/// </summary>
+gamzia::ConnectionPool::~ConnectionPool()
+{
+   myfreereaders.clear();
+   myreaders.clear();
+   mywriter.reset();
+}
+
+bool gamzia::ConnectionPool::isReady()
+{
+   return (isReadyFlag);
+}
+
+std::string gamzia::ConnectionPool::getLastError()
+{
+   return (myerror);
+}
+
+/// <summary>
+/// Leases a read-only connection, waiting up to timeout for one to free up.
+/// </summary>
+/// <param name="timeout">Maximum wait.</param>
+/// <returns>The lease; invalid on timeout.</returns>
+gamzia::ConnectionLease gamzia::ConnectionPool::acquireReader(std::chrono::milliseconds timeout)
+{
+   std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+   std::unique_lock<std::mutex> guard(mylock);
+   bool waited = myfreereaders.empty();
+
+   if (!isReadyFlag || !myreaderfreed.wait_for(guard, timeout, [this] { return !myfreereaders.empty(); }))
+   {
+      mystats.timeouts++;
+      recordWait(waited, start);
+      return (ConnectionLease());
+   }
+
+   Sqlite* connection = myfreereaders.back();
+   myfreereaders.pop_back();
+   mystats.leases++;
+   mystats.readersInUse++;
+   mystats.peakReadersInUse = std::max(mystats.peakReadersInUse, mystats.readersInUse);
+   recordWait(waited, start);
+   return (ConnectionLease(this, connection, false));
+}
+
+/// <summary>
+/// Leases the writer connection, waiting up to timeout for the current
+/// holder to finish.
+/// </summary>
+/// <param name="timeout">Maximum wait.</param>
+/// <returns>The lease; invalid on timeout.</returns>
+gamzia::ConnectionLease gamzia::ConnectionPool::acquireWriter(std::chrono::milliseconds timeout)
+{
+   std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+   std::unique_lock<std::mutex> guard(mylock);
+   bool waited = !isWriterFree;
+
+   if (!isReadyFlag || !mywriterfreed.wait_for(guard, timeout, [this] { return isWriterFree; }))
+   {
+      mystats.timeouts++;
+      recordWait(waited, start);
+      return (ConnectionLease());
+   }
+
+   isWriterFree = false;
+   mystats.leases++;
+   mystats.writerInUse = true;
+   recordWait(waited, start);
+   return (ConnectionLease(this, mywriter.get(), true));
+}
+
+/// <summary>
+/// Returns a snapshot of the pool's counters.
+/// </summary>
+gamzia::ConnectionPoolStats gamzia::ConnectionPool::getStats()
+{
+   std::lock_guard<std::mutex> guard(mylock);
+   ConnectionPoolStats stats = mystats;
+   unsigned long long attempts = stats.leases + stats.timeouts;
+   stats.saturation = (attempts == 0 ? 0.0 : (double)stats.waits / (double)attempts);
+   return (stats);
+}
+
+/// <summary>
+/// Zeroes the counters (ie, per reporting interval); the in-use counts
+/// are kept.
+/// </summary>
+void gamzia::ConnectionPool::resetStats()
+{
+   std::lock_guard<std::mutex> guard(mylock);
+   mystats.leases = 0;
+   mystats.waits = 0;
+   mystats.timeouts = 0;
+   mystats.waitMicros = 0;
+   mystats.maxWaitMicros = 0;
+   mystats.peakReadersInUse = mystats.readersInUse;
+}
+
+/// <summary>
+/// Attaches one QueryProfiler to every connection, so the report covers
+/// the whole pool.  Call before handing out leases.
+/// </summary>
+/// <param name="profiler">The profiler; nullptr detaches it.</param>
+void gamzia::ConnectionPool::setProfiler(std::shared_ptr<QueryProfiler> profiler)
+{
+   std::lock_guard<std::mutex> guard(mylock);
+   if (mywriter)
+      mywriter->setProfiler(profiler);
+   for (std::unique_ptr<Sqlite>& reader : myreaders)
+      reader->setProfiler(profiler);
+}
+
+/// <summary>
+/// Subscribes to the changes committed through the pool.  All writes go
+/// through the one writer connection, so its feed sees every one; the
+/// writer is leased while the hooks are installed.
+/// </summary>
+/// <param name="listener">Called on the thread holding the writer lease,
+/// after each commit; it must not use that lease.</param>
+/// <param name="table">Only changes to this table; empty for all.</param>
+/// <returns>An id for unsubscribe(); 0 if the writer was unavailable.</returns>
+int gamzia::ConnectionPool::subscribe(ChangeListener listener, std::string table)
+{
+   ConnectionLease lease = acquireWriter();
+   if (!lease.isValid())
+      return (0);
+   return (lease->subscribe(std::move(listener), std::move(table)));
+}
+
+bool gamzia::ConnectionPool::unsubscribe(int id)
+{
+   ConnectionLease lease = acquireWriter();
+   return (lease.isValid() && lease->unsubscribe(id));
+}
+
+bool gamzia::ConnectionPool::open(Sqlite& connection, int flags, int busyTimeout)
+{
+   if (!connection.connect(flags) || !connection.setBusyTimeout(busyTimeout))
+   {
+      myerror = connection.getLastError();
+      return false;
+   }
+   return true;
+}
+
+/// <summary>
+/// Accounts for one acquisition; called with mylock held.
+/// </summary>
+void gamzia::ConnectionPool::recordWait(bool waited, std::chrono::steady_clock::time_point start)
+{
+   if (!waited)
+      return;
+
+   unsigned long long micros = (unsigned long long)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start).count();
+   mystats.waits++;
+   mystats.waitMicros += micros;
+   mystats.maxWaitMicros = std::max(mystats.maxWaitMicros, micros);
+}
+
+/// <summary>
+/// Takes a connection back from a lease and wakes one waiter.
+/// </summary>
+void gamzia::ConnectionPool::release(Sqlite* connection, bool writer)
+{
+   // A holder that bailed out mid-transaction must not pass it on
+   sqlite3* handle = connection->getHandle();
+   if (handle != nullptr && !sqlite3_get_autocommit(handle))
+      sqlite3_exec(handle, "ROLLBACK", NULL, NULL, NULL);
+
+   {
+      std::lock_guard<std::mutex> guard(mylock);
+      if (writer)
+      {
+         isWriterFree = true;
+         mystats.writerInUse = false;
+      }
+      else
+      {
+         myfreereaders.push_back(connection);
+         mystats.readersInUse--;
+      }
+   }
+
+   if (writer)
+      mywriterfreed.notify_one();
+   else
+      myreaderfreed.notify_one();
+}
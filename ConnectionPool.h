@@ -0,0 +1,105 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "Sqlite.h"
+
+namespace gamzia
+{
+
+   class ConnectionPool;
+
+   struct ConnectionPoolStats
+   {
+      unsigned long long leases;          // successful acquisitions
+      unsigned long long waits;           // acquisitions that found nothing free
+      unsigned long long timeouts;        // acquisitions that gave up
+      unsigned long long waitMicros;      // total time spent waiting
+      unsigned long long maxWaitMicros;
+      size_t readers;
+      size_t readersInUse;
+      size_t peakReadersInUse;
+      bool writerInUse;
+      double saturation;                  // waits / acquisition attempts
+   };
+
+   /// <summary>
+   /// A connection borrowed from a ConnectionPool; handed back when the
+   /// lease is destroyed.  Move-only.  Check isValid() (acquisition can
+   /// time out) and use it from one thread at a time.
+   /// </summary>
+   class ConnectionLease
+   {
+
+   public:
+      ConnectionLease();
+      ~ConnectionLease();
+      ConnectionLease(const ConnectionLease&) = delete;
+      ConnectionLease& operator=(const ConnectionLease&) = delete;
+      ConnectionLease(ConnectionLease&& other) noexcept;
+      ConnectionLease& operator=(ConnectionLease&& other) noexcept;
+
+      bool isValid() const;
+      bool isWriter() const;
+      Sqlite& get();
+      Sqlite* operator->();
+      Cursor getCursor();
+      void release();
+
+   private:
+      friend class ConnectionPool;
+      ConnectionLease(ConnectionPool *pool, Sqlite *connection, bool writer);
+
+      ConnectionPool *mypool;
+      Sqlite         *myconnection;
+      bool           isWriterFlag;
+   };
+
+   class ConnectionPool
+   {
+
+   public:
+      ConnectionPool(std::string dbname);
+      ConnectionPool(std::string dbname, size_t readers, int busyTimeout = BUSY_TIMEOUT);
+      ~ConnectionPool();
+      ConnectionPool(const ConnectionPool&) = delete;
+      ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+      bool isReady();
+      std::string getLastError();
+      ConnectionLease acquireReader(std::chrono::milliseconds timeout = std::chrono::milliseconds(BUSY_TIMEOUT));
+      ConnectionLease acquireWriter(std::chrono::milliseconds timeout = std::chrono::milliseconds(BUSY_TIMEOUT));
+      ConnectionPoolStats getStats();
+      void resetStats();
+      void setProfiler(std::shared_ptr<QueryProfiler> profiler);
+      int subscribe(ChangeListener listener, std::string table = "");
+      bool unsubscribe(int id);
+
+      inline static const size_t DEFAULT_READERS = 4;
+      inline static const int BUSY_TIMEOUT = 5000;
+
+   private:
+      friend class ConnectionLease;
+
+      std::string mydbname;
+      bool isReadyFlag;
+      std::string myerror;
+      std::unique_ptr<Sqlite> mywriter;
+      std::vector<std::unique_ptr<Sqlite>> myreaders;
+      std::vector<Sqlite*> myfreereaders;
+      bool isWriterFree;
+
+      std::mutex mylock;
+      std::condition_variable myreaderfreed;
+      std::condition_variable mywriterfreed;
+      ConnectionPoolStats mystats;
+
+      bool open(Sqlite& connection, int flags, int busyTimeout);
+      void recordWait(bool waited, std::chrono::steady_clock::time_point start);
+      void release(Sqlite *connection, bool writer);
+   }; // class
+
+}; // namespace
@@ -0,0 +1,548 @@
+/*
+* Class CsvIO
+* ===========
+*
+* Bulk CSV / TSV import and export for Sqlite tables, for data refreshes
+* of millions of rows.
+*
+* Import maps the file into memory (mmap; read whole on Windows) and parses
+* it in place: unquoted fields are found with an SSE2 scan for the
+* delimiter and line ends, 16 bytes per step (with a scalar fallback), and
+* are bound straight from the mapping, without a std::string per field.
+* Only quoted fields containing "" escapes are copied.  Rows go in through
+* a reused prepared statement carrying ROWS_PER_STATEMENT rows at a time,
+* in transactions of batchSize rows.  If the table does not exist it is
+* created from the header (untyped columns, like the sqlite3 shell).
+* Records with missing fields get NULLs, and extra fields are dropped;
+* both are counted as malformed.
+*
+* Export streams the rows of a table or query through Cursor::query(),
+* straight into a WRITE_BUFFER sized buffer flushed to the file as it fills,
+* so no fetchAll() table is ever built.  Fields are quoted only when they
+* contain the delimiter, a quote or a line end; NULL is an empty field.
+*
+-->
+gamzia::CsvIO csv = gamzia::CsvIO(db);
+csv.importFile("accounts.csv", "accounts");
+
+gamzia::CsvOptions tsv;
+tsv.delimiter = '\t';
+csv.exportQuery("SELECT user, created FROM accounts WHERE created > ?", "recent.tsv", tsv, { since });
+<--
+*/
+
+#include "CsvIO.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <bit>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define CSVIO_SSE2
+#endif
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+/// <summary>
+/// Constructor.
+/// </summary>
+/// <param name="db">An open database.</param>
+gamzia::CsvIO::CsvIO(Sqlite& db)
+   : mydb(db)
+{
+   mystats = CsvStats();
+}
+
+/// <summary>
+/// Imports a CSV (or TSV) file into table.  Joins the caller's
+/// transaction if one is open; otherwise commits every batchSize rows and
+/// rolls back the current batch on error.
+/// </summary>
+/// <param name="path">The file.</param>
+/// <param name="table">The table; created from the header if missing.</param>
+/// <param name="options">Delimiter, header, batching.</param>
+/// <returns>True if every record was inserted.</returns>
+bool gamzia::CsvIO::importFile(std::string path, std::string table, CsvOptions options)
+{
+   std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+   sqlite3* handle = mydb.getHandle();
+   MappedFile file;
+   std::vector<std::string_view> fields;
+   std::vector<std::string> names;
+   std::deque<std::string> scratch;
+   sqlite3_stmt* multi = nullptr;
+   sqlite3_stmt* single = nullptr;
+   bool ownTransaction = false;
+   bool ok = true;
+
+   mystats = CsvStats();
+   myerror.clear();
+   if (handle == nullptr)
+      return fail("Database not connected");
+   if (options.delimiter == '"' || options.delimiter == '\n' || options.delimiter == '\r')
+      return fail("Invalid delimiter");
+   if (!file.open(path, myerror))
+      return false;
+
+   const char* p = file.data;
+   const char* end = file.data + file.size;
+   mystats.bytes = file.size;
+   if (file.size >= 3 && memcmp(p, "\xEF\xBB\xBF", 3) == 0)
+      p += 3;
+   while (p < end && (*p == '\n' || *p == '\r'))
+      p++;
+   if (p >= end)
+      return (options.header ? fail("No header in " + path) : true);
+
+   // The first record fixes the column count (and names, from a header)
+   const char* firstRecord = p;
+   if (!parseRecord(p, end, options.delimiter, fields, scratch))
+      return fail("Unterminated quoted field in record 1");
+   size_t columns = fields.size();
+   if (options.header)
+   {
+      for (std::string_view name : fields)
+         names.push_back(std::string(name));
+   }
+   else
+      p = firstRecord;
+   scratch.clear();
+
+   Cursor k = mydb.getCursor();
+   if (!k.doesTableExist(table))
+   {
+      if (!options.createTable)
+         return fail("No such table: " + table);
+
+      std::string sql = "CREATE TABLE " + quote(table) + " (";
+      for (size_t i = 0; i < columns; i++)
+         sql += (i == 0 ? "" : ", ") + quote(names.empty() ? "c" + std::to_string(i + 1) : names[i]);
+      if (!k.execute(sql + ")"))
+         return fail(mydb.getLastError());
+   }
+
+   // As many rows per INSERT as the host parameter limit allows
+   size_t perStatement = (size_t)sqlite3_limit(handle, SQLITE_LIMIT_VARIABLE_NUMBER, -1) / columns;
+   perStatement = std::max((size_t)1, std::min(perStatement, ROWS_PER_STATEMENT));
+   if (!prepareInsert(table, names, columns, perStatement, &multi) ||
+      !prepareInsert(table, names, columns, 1, &single))
+   {
+      sqlite3_finalize(multi);
+      return false;
+   }
+
+   ownTransaction = (sqlite3_get_autocommit(handle) != 0);
+   if (ownTransaction && sqlite3_exec(handle, "BEGIN", NULL, NULL, NULL) != SQLITE_OK)
+      ok = fail(sqlite3_errmsg(handle));
+
+   // One group of rows: views into the mapping (or scratch); a null
+   // data() is a missing field, bound as NULL
+   std::vector<std::string_view> group(perStatement * columns);
+   size_t inGroup = 0;
+   size_t inBatch = 0;
+   unsigned long long record = (options.header ? 1 : 0);
+
+   while (ok && (p < end || inGroup > 0))
+   {
+      if (p < end)
+      {
+         if (*p == '\n' || *p == '\r')
+         {
+            p++;
+            continue;
+         }
+         record++;
+         if (!parseRecord(p, end, options.delimiter, fields, scratch))
+         {
+            ok = fail("Unterminated quoted field in record " + std::to_string(record));
+            break;
+         }
+         if (fields.size() != columns)
+            mystats.malformed++;
+         for (size_t c = 0; c < columns; c++)
+            group[inGroup * columns + c] = (c < fields.size() ? fields[c] : std::string_view());
+         inGroup++;
+         if (inGroup < perStatement && p < end)
+            continue;
+      }
+
+      // A full group goes in one statement; a short last one row by row
+      sqlite3_stmt* statement = (inGroup == perStatement ? multi : single);
+      size_t perStep = (inGroup == perStatement ? perStatement : 1);
+      for (size_t row = 0; ok && row < inGroup; row += perStep)
+      {
+         for (size_t i = 0; i < perStep * columns; i++)
+         {
+            std::string_view value = group[row * columns + i];
+            if (value.data() == nullptr)
+               sqlite3_bind_null(statement, (int)i + 1);
+            else
+               sqlite3_bind_text(statement, (int)i + 1, value.data(), (int)value.size(), SQLITE_STATIC);
+         }
+         if (sqlite3_step(statement) != SQLITE_DONE)
+            ok = fail(std::string(sqlite3_errmsg(handle)) + " near record " + std::to_string(record));
+         sqlite3_reset(statement);
+      }
+      if (!ok)
+         break;
+
+      mystats.rows += inGroup;
+      inBatch += inGroup;
+      inGroup = 0;
+      scratch.clear();
+
+      if (ownTransaction && options.batchSize > 0 && inBatch >= options.batchSize)
+      {
+         if (sqlite3_exec(handle, "COMMIT", NULL, NULL, NULL) != SQLITE_OK)
+            ok = fail(sqlite3_errmsg(handle));
+         mydb.flushChanges();
+         if (ok && sqlite3_exec(handle, "BEGIN", NULL, NULL, NULL) != SQLITE_OK)
+            ok = fail(sqlite3_errmsg(handle));
+         inBatch = 0;
+      }
+   }
+
+   sqlite3_finalize(multi);
+   sqlite3_finalize(single);
+   if (ownTransaction)
+   {
+      if (ok && sqlite3_exec(handle, "COMMIT", NULL, NULL, NULL) != SQLITE_OK)
+         ok = fail(sqlite3_errmsg(handle));
+      if (!ok)
+         sqlite3_exec(handle, "ROLLBACK", NULL, NULL, NULL);
+      mydb.flushChanges();
+   }
+
+   mystats.micros = (unsigned long long)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start).count();
+   return (ok);
+}
+
+/// <summary>
+/// Exports a whole table.
+/// </summary>
+bool gamzia::CsvIO::exportTable(std::string table, std::string path, CsvOptions options)
+{
+   return exportQuery("SELECT * FROM " + quote(table), path, options);
+}
+
+/// <summary>
+/// Streams the rows of a query to a CSV (or TSV) file.
+/// </summary>
+/// <param name="sql">The query.</param>
+/// <param name="path">The file; replaced if it exists.</param>
+/// <param name="options">Delimiter and header.</param>
+/// <param name="params">Values for the query's '?' parameters.</param>
+/// <returns>True if every row was written.</returns>
+bool gamzia::CsvIO::exportQuery(std::string sql, std::string path, CsvOptions options,
+   const std::vector<std::string> params)
+{
+   std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+   std::string buffer;
+   bool ok = true;
+
+   mystats = CsvStats();
+   myerror.clear();
+
+   Cursor k = mydb.getCursor();
+   Query rows = k.query(sql, params);
+   if (!rows.isValid())
+      return fail(mydb.getLastError());
+
+   FILE* out = fopen(path.c_str(), "wb");
+   if (out == nullptr)
+      return fail("Unable to create " + path);
+
+   buffer.reserve(WRITE_BUFFER + 4096);
+   if (options.header)
+   {
+      std::vector<std::string> names = k.getColumnNames();
+      for (size_t c = 0; c < names.size(); c++)
+      {
+         if (c > 0)
+            buffer += options.delimiter;
+         appendField(buffer, names[c], options.delimiter);
+      }
+      buffer += '\n';
+   }
+
+   for (Row row : rows)
+   {
+      int count = row.getColumnCount();
+      for (int c = 0; c < count; c++)
+      {
+         if (c > 0)
+            buffer += options.delimiter;
+         if (row.getType(c) != SQLITE_NULL)
+            appendField(buffer, row.getText(c), options.delimiter);
+      }
+      buffer += '\n';
+      mystats.rows++;
+
+      if (buffer.size() >= WRITE_BUFFER)
+      {
+         ok = ok && (fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size());
+         mystats.bytes += buffer.size();
+         buffer.clear();
+      }
+   }
+
+   // The loop ends quietly on a step error as well as at the end
+   int rc = sqlite3_errcode(mydb.getHandle());
+   if (rc != SQLITE_OK && rc != SQLITE_DONE && rc != SQLITE_ROW)
+      ok = fail(mydb.getLastError());
+
+   ok = ok && (fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size());
+   mystats.bytes += buffer.size();
+   if (fclose(out) != 0 || (!ok && myerror.empty()))
+      ok = fail("Unable to write " + path);
+
+   mystats.micros = (unsigned long long)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start).count();
+   return (ok);
+}
+
+/// <summary>
+/// Rows, malformed records, bytes and time of the last import or export.
+/// </summary>
+gamzia::CsvStats gamzia::CsvIO::getStats()
+{
+   return (mystats);
+}
+
+std::string gamzia::CsvIO::getLastError()
+{
+   return (myerror);
+}
+
+/// <summary>
+/// Returns the first delimiter, '\n' or '\r' in [p, end), or end.  SSE2
+/// compares 16 bytes against all three at once where available.
+/// </summary>
+const char* gamzia::CsvIO::findSpecial(const char* p, const char* end, char delimiter)
+{
+#ifdef CSVIO_SSE2
+   const __m128i delimiters = _mm_set1_epi8(delimiter);
+   const __m128i newlines = _mm_set1_epi8('\n');
+   const __m128i returns = _mm_set1_epi8('\r');
+
+   while (end - p >= 16)
+   {
+      __m128i block = _mm_loadu_si128((const __m128i*)p);
+      __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(block, delimiters),
+         _mm_or_si128(_mm_cmpeq_epi8(block, newlines), _mm_cmpeq_epi8(block, returns)));
+      unsigned int mask = (unsigned int)_mm_movemask_epi8(hits);
+      if (mask != 0)
+         return (p + std::countr_zero(mask));
+      p += 16;
+   }
+#endif
+
+   while (p < end && *p != delimiter && *p != '\n' && *p != '\r')
+      p++;
+   return (p);
+}
+
+/// <summary>
+/// Parses one record starting at p and leaves p at the start of the next.
+/// Fields are views into the input; a quoted field with "" escapes is
+/// unescaped into scratch (a deque, so earlier views stay valid).
+/// </summary>
+/// <returns>False on an unterminated quoted field.</returns>
+bool gamzia::CsvIO::parseRecord(const char*& p, const char* end, char delimiter,
+   std::vector<std::string_view>& fields, std::deque<std::string>& scratch)
+{
+   fields.clear();
+
+   for (;;)
+   {
+      if (p < end && *p == '"')
+      {
+         // Quoted: runs to the next quote not followed by another
+         const char* first = ++p;
+         bool escaped = false;
+         for (;;)
+         {
+            const char* q = (const char*)memchr(p, '"', (size_t)(end - p));
+            if (q == nullptr)
+               return false;
+            if (q + 1 < end && q[1] == '"')
+            {
+               escaped = true;
+               p = q + 2;
+               continue;
+            }
+            fields.push_back(std::string_view(first, (size_t)(q - first)));
+            p = q + 1;
+            break;
+         }
+
+         if (escaped)
+         {
+            std::string& text = scratch.emplace_back();
+            for (const char* c = first; c < first + fields.back().size(); c++)
+            {
+               text += *c;
+               if (*c == '"')
+                  c++;
+            }
+            fields.back() = text;
+         }
+
+         // Anything between the closing quote and the delimiter is dropped
+         p = findSpecial(p, end, delimiter);
+      }
+      else
+      {
+         const char* q = findSpecial(p, end, delimiter);
+         fields.push_back(std::string_view(p, (size_t)(q - p)));
+         p = q;
+      }
+
+      if (p < end && *p == delimiter)
+      {
+         p++;
+         continue;
+      }
+
+      // End of record: \n, \r\n or \r
+      if (p < end && *p == '\r')
+         p++;
+      if (p < end && *p == '\n')
+         p++;
+      return true;
+   }
+}
+
+/// <summary>
+/// Appends a field, quoted only if it holds the delimiter, a quote or a
+/// line end.
+/// </summary>
+void gamzia::CsvIO::appendField(std::string& out, std::string_view field, char delimiter)
+{
+   const char* end = field.data() + field.size();
+
+   if (findSpecial(field.data(), end, delimiter) == end && field.find('"') == std::string_view::npos)
+   {
+      out.append(field);
+      return;
+   }
+
+   out += '"';
+   for (char c : field)
+   {
+      if (c == '"')
+         out += '"';
+      out += c;
+   }
+   out += '"';
+}
+
+/// <summary>
+/// Prepares INSERT INTO table [(columns)] VALUES (...), (...) with rows
+/// groups; names come from the header when there is one.
+/// </summary>
+bool gamzia::CsvIO::prepareInsert(const std::string& table, const std::vector<std::string>& names, size_t columns,
+   size_t rows, sqlite3_stmt** statement)
+{
+   std::string group = "(";
+   std::string sql = "INSERT INTO " + quote(table) + " ";
+
+   // By name when there is a header, so its column order need not match
+   for (size_t c = 0; c < names.size(); c++)
+      sql += (c == 0 ? "(" : ", ") + quote(names[c]) + (c + 1 == names.size() ? ") " : "");
+   sql += "VALUES ";
+
+   for (size_t c = 0; c < columns; c++)
+      group += (c == 0 ? "?" : ", ?");
+   group += ")";
+   for (size_t r = 0; r < rows; r++)
+      sql += (r == 0 ? "" : ", ") + group;
+
+   *statement = nullptr;
+   if (sqlite3_prepare_v3(mydb.getHandle(), sql.c_str(), -1, SQLITE_PREPARE_PERSISTENT, statement, NULL) != SQLITE_OK)
+      return fail(mydb.getLastError());
+   return true;
+}
+
+bool gamzia::CsvIO::fail(const std::string& message)
+{
+   myerror = message;
+   return false;
+}
+
+std::string gamzia::CsvIO::quote(const std::string& identifier)
+{
+   std::string quoted = "\"";
+   for (char c : identifier)
+      quoted += (c == '"' ? std::string("\"\"") : std::string(1, c));
+   return (quoted + "\"");
+}
+
+/*****************************
+*  Struct CsvIO::MappedFile  *
+*****************************/
+
+/// <summary>
+/// Maps the file read-only (reads it whole where mmap is unavailable).
+/// </summary>
+bool gamzia::CsvIO::MappedFile::open(const std::string& path, std::string& error)
+{
+#ifdef _WIN32
+   std::ifstream in(path, std::ios::in | std::ios::binary | std::ios::ate);
+   if (!in)
+   {
+      error = "Unable to open " + path;
+      return false;
+   }
+   copy.resize((size_t)in.tellg());
+   in.seekg(0);
+   in.read(copy.data(), (std::streamsize)copy.size());
+   data = copy.data();
+   size = copy.size();
+   return true;
+#else
+   struct stat info;
+   int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+   if (fd < 0 || fstat(fd, &info) != 0)
+   {
+      if (fd >= 0)
+         close(fd);
+      error = "Unable to open " + path;
+      return false;
+   }
+
+   size = (size_t)info.st_size;
+   data = "";
+   if (size > 0)
+   {
+      void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapping == MAP_FAILED)
+      {
+         close(fd);
+         error = "Unable to map " + path;
+         return false;
+      }
+      madvise(mapping, size, MADV_SEQUENTIAL);
+      data = (const char*)mapping;
+      isMapped = true;
+   }
+   close(fd);
+   return true;
+#endif
+}
+
+gamzia::CsvIO::MappedFile::~MappedFile()
+{
+#ifndef _WIN32
+   if (isMapped)
+      munmap((void*)data, size);
+#endif
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <cstdio>
+#include "Sqlite.h"
+
+namespace gamzia
+{
+
+   /// <summary>
+   /// Options for CsvIO.  delimiter '\t' for TSV.  header: the first line
+   /// holds column names (import) / write one (export).  batchSize: rows per
+   /// transaction on import; 0 for a single transaction.
+   /// </summary>
+   struct CsvOptions
+   {
+      char delimiter = ',';
+      bool header = true;
+      bool createTable = true;
+      size_t batchSize = 100000;
+   };
+
+   struct CsvStats
+   {
+      unsigned long long rows;
+      unsigned long long malformed;       // records with too few or too many fields
+      unsigned long long bytes;
+      unsigned long long micros;
+   };
+
+   class CsvIO
+   {
+
+   public:
+      CsvIO(Sqlite& db);
+
+      bool importFile(std::string path, std::string table, CsvOptions options = CsvOptions());
+      bool exportTable(std::string table, std::string path, CsvOptions options = CsvOptions());
+      bool exportQuery(std::string sql, std::string path, CsvOptions options = CsvOptions(),
+         const std::vector<std::string> params = {});
+      CsvStats getStats();
+      std::string getLastError();
+
+      inline static const size_t ROWS_PER_STATEMENT = 32;
+      inline static const size_t WRITE_BUFFER = 1 << 20;
+
+      static const char* findSpecial(const char* p, const char* end, char delimiter);
+
+   private:
+      struct MappedFile
+      {
+         const char* data = nullptr;
+         size_t size = 0;
+         bool isMapped = false;
+         std::vector<char> copy;          // no mmap (Windows)
+
+         bool open(const std::string& path, std::string& error);
+         ~MappedFile();
+      };
+
+      Sqlite& mydb;
+      std::string myerror;
+      CsvStats mystats;
+
+      bool prepareInsert(const std::string& table, const std::vector<std::string>& names, size_t columns,
+         size_t rows, sqlite3_stmt** statement);
+      bool fail(const std::string& message);
+      static bool parseRecord(const char*& p, const char* end, char delimiter,
+         std::vector<std::string_view>& fields, std::deque<std::string>& scratch);
+      static void appendField(std::string& out, std::string_view field, char delimiter);
+      static std::string quote(const std::string& identifier);
+   }; // class
+
+}; // namespace
@@ -0,0 +1,227 @@
+/*
+* Class HMACSHA256
+* ================
+*
+* HMAC-SHA256 (RFC 2104) and PBKDF2-HMAC-SHA256 (RFC 8018), built on the
+* SHA256 class.
+*
+* The key is only ever compressed once: setKey() hashes the (key ^ ipad) and
+* (key ^ opad) blocks and keeps the resulting SHA256 states, the "midstates".
+* Every MAC afterwards starts by restoring a midstate instead of rehashing the
+* pads.  For short messages this halves the compression calls per MAC, and
+* PBKDF2 - which computes one MAC per iteration with the same key - gets the
+* full benefit: each iteration costs exactly two compressions.
+*
+-->
+gamzia::HMACSHA256 hmac = gamzia::HMACSHA256("secret key");
+hmac.update("message");
+unsigned char mac[gamzia::HMACSHA256::DIGEST_SIZE];
+hmac.final(mac);
+
+// Password stretching
+std::string dk = gamzia::HMACSHA256::pbkdf2Hex(password, salt, 100000);
+<--
+*/
+
+#include "HMACSHA256.h"
+#include <cstring>
+#include "SHA256.h"
+
+static const unsigned char IPAD = 0x36;
+static const unsigned char OPAD = 0x5c;
+
+
+/// <summary>
+/// Default constructor; uses an empty key until setKey() is called.
+/// </summary>
+gamzia::HMACSHA256::HMACSHA256()
+{
+   setKey(nullptr, 0);
+}
+
+
+/// <summary>
+/// Constructor; sets the key and readies the first MAC.
+/// </summary>
+/// <param name="key">The secret key.</param>
+gamzia::HMACSHA256::HMACSHA256(std::string_view key)
+{
+   setKey(key);
+}
+
+
+/// <summary>
+/// Sets the key and precomputes the inner and outer midstates.
+/// Keys longer than a block are hashed first, per RFC 2104.
+/// </summary>
+/// <param name="key">The secret key.</param>
+/// <param name="len">Key length in bytes.</param>
+void gamzia::HMACSHA256::setKey(const unsigned char* key, size_t len)
+{
+   unsigned char block[SHA256::BLOCK_SIZE];
+   unsigned char pad[SHA256::BLOCK_SIZE];
+   SHA256 ctx = SHA256();
+
+   memset(block, 0, sizeof(block));
+   if (len > SHA256::BLOCK_SIZE)
+   {
+      ctx.init();
+      ctx.update(key, len);
+      ctx.final(block);
+   }
+   else if (len > 0)
+      memcpy(block, key, len);
+
+   for (size_t i = 0; i < sizeof(pad); i++)
+      pad[i] = block[i] ^ IPAD;
+   ctx.init();
+   ctx.update(pad, sizeof(pad));
+   myinner = ctx.saveState();
+
+   for (size_t i = 0; i < sizeof(pad); i++)
+      pad[i] = block[i] ^ OPAD;
+   ctx.init();
+   ctx.update(pad, sizeof(pad));
+   myouter = ctx.saveState();
+
+   memset(block, 0, sizeof(block));
+   memset(pad, 0, sizeof(pad));
+   init();
+}
+
+
+void gamzia::HMACSHA256::setKey(std::string_view key)
+{
+   setKey((const unsigned char*)key.data(), key.size());
+}
+
+
+/// <summary>
+/// Starts a new MAC with the current key (restores the inner midstate).
+/// </summary>
+void gamzia::HMACSHA256::init()
+{
+   myctx.restoreState(myinner);
+}
+
+
+void gamzia::HMACSHA256::update(const unsigned char* message, size_t len)
+{
+   myctx.update(message, len);
+}
+
+
+void gamzia::HMACSHA256::update(std::string_view message)
+{
+   myctx.update(message);
+}
+
+
+/// <summary>
+/// Finishes the MAC and readies the object for the next message.
+/// </summary>
+/// <param name="mac">Receives DIGEST_SIZE bytes.</param>
+void gamzia::HMACSHA256::final(unsigned char* mac)
+{
+   unsigned char inner[SHA256::DIGEST_SIZE];
+
+   myctx.final(inner);
+   myctx.restoreState(myouter);
+   myctx.update(inner, sizeof(inner));
+   myctx.final(mac);
+   init();
+}
+
+
+/// <summary>
+/// One shot HMAC-SHA256.
+/// </summary>
+SHA256Digest gamzia::HMACSHA256::mac(std::string_view key, std::string_view message)
+{
+   SHA256Digest digest;
+   HMACSHA256 hmac = HMACSHA256(key);
+
+   hmac.update(message);
+   hmac.final(digest.data());
+   return (digest);
+}
+
+
+/// <summary>
+/// PBKDF2-HMAC-SHA256.  The password's midstates are computed once and
+/// reused for every iteration of every output block.
+/// </summary>
+/// <param name="password">The password (HMAC key).</param>
+/// <param name="salt">The salt.</param>
+/// <param name="iterations">Iteration count; must be at least 1.</param>
+/// <param name="out">Receives the derived key.</param>
+/// <param name="outLen">Derived key length in bytes.</param>
+/// <returns>True on success, false on invalid parameters.</returns>
+bool gamzia::HMACSHA256::pbkdf2(std::string_view password, std::string_view salt, unsigned int iterations,
+   unsigned char* out, size_t outLen)
+{
+   unsigned char u[DIGEST_SIZE];
+   unsigned char t[DIGEST_SIZE];
+   unsigned char counter[4];
+   unsigned long long blocks;
+
+   // RFC 8018 limits the derived key to (2^32 - 1) blocks
+   blocks = ((unsigned long long)outLen + DIGEST_SIZE - 1) / DIGEST_SIZE;
+   if (iterations == 0 || out == nullptr || blocks > 0xffffffffULL)
+      return false;
+
+   HMACSHA256 hmac = HMACSHA256(password);
+   for (unsigned long long block = 1; block <= blocks; block++)
+   {
+      counter[0] = (unsigned char)(block >> 24);
+      counter[1] = (unsigned char)(block >> 16);
+      counter[2] = (unsigned char)(block >> 8);
+      counter[3] = (unsigned char)(block);
+
+      // U1 = PRF(P, S || INT(i))
+      hmac.update(salt);
+      hmac.update(counter, sizeof(counter));
+      hmac.final(u);
+      memcpy(t, u, sizeof(t));
+
+      // Uj = PRF(P, Uj-1); T = U1 ^ U2 ^ ... ^ Uc
+      for (unsigned int j = 1; j < iterations; j++)
+      {
+         hmac.update(u, sizeof(u));
+         hmac.final(u);
+         for (size_t k = 0; k < sizeof(t); k++)
+            t[k] ^= u[k];
+      }
+
+      size_t offset = (size_t)(block - 1) * DIGEST_SIZE;
+      size_t take = (outLen - offset < DIGEST_SIZE) ? outLen - offset : DIGEST_SIZE;
+      memcpy(out + offset, t, take);
+   }
+
+   memset(u, 0, sizeof(u));
+   memset(t, 0, sizeof(t));
+   return true;
+}
+
+
+/// <summary>
+/// PBKDF2-HMAC-SHA256, returned as a lowercase hex string.
+/// </summary>
+/// <returns>The derived key in hex, or an empty string on invalid parameters.</returns>
+std::string gamzia::HMACSHA256::pbkdf2Hex(std::string_view password, std::string_view salt,
+   unsigned int iterations, size_t outLen)
+{
+   static const char hex[] = "0123456789abcdef";
+   std::string key(outLen, '\0');
+   std::string text(outLen * 2, '0');
+
+   if (!pbkdf2(password, salt, iterations, (unsigned char*)key.data(), outLen))
+      return "";
+
+   for (size_t i = 0; i < outLen; i++)
+   {
+      text[i * 2] = hex[(unsigned char)key[i] >> 4];
+      text[i * 2 + 1] = hex[(unsigned char)key[i] & 0x0f];
+   }
+   return (text);
+}
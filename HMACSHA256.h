@@ -0,0 +1,36 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include "SHA256.h"
+
+namespace gamzia
+{
+
+   class HMACSHA256
+   {
+   public:
+      HMACSHA256();
+      HMACSHA256(std::string_view key);
+
+      void setKey(const unsigned char* key, size_t len);
+      void setKey(std::string_view key);
+      void init();
+      void update(const unsigned char* message, size_t len);
+      void update(std::string_view message);
+      void final(unsigned char* mac);
+
+      static SHA256Digest mac(std::string_view key, std::string_view message);
+      static bool pbkdf2(std::string_view password, std::string_view salt, unsigned int iterations,
+         unsigned char* out, size_t outLen);
+      static std::string pbkdf2Hex(std::string_view password, std::string_view salt,
+         unsigned int iterations, size_t outLen = SHA256::DIGEST_SIZE);
+
+      static const unsigned int DIGEST_SIZE = SHA256::DIGEST_SIZE;
+
+   private:
+      SHA256        myctx;
+      SHA256::State myinner;
+      SHA256::State myouter;
+   }; // class
+
+}; // namespace
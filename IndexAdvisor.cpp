@@ -0,0 +1,752 @@
+/*
+* Class IndexAdvisor
+* ==================
+*
+* An opt-in index advisor for the Sqlite wrapper, driven by EXPLAIN QUERY
+* PLAN.
+*
+* Feed it statements (one at a time, or everything a QueryProfiler has
+* seen, with its call counts) and it asks SQLite for each one's query plan.
+* Plan steps that show missing indexes are turned into suggestions:
+*
+*    SCAN t                              a full table scan despite a WHERE
+*    SEARCH t USING AUTOMATIC INDEX      SQLite built a throwaway index
+*    USE TEMP B-TREE FOR ORDER BY        a sort (also GROUP BY / DISTINCT)
+*
+* Index columns come from the statement itself: equality constraints
+* first, then the ORDER BY / GROUP BY columns or a single range constraint.
+* When the select list is a few plain columns of the same table they are
+* appended, making the index covering.  Suggestions are keyed by table and
+* columns, so the same index wanted by many statements is one entry; the
+* report ranks them by how many executions would use them.
+*
+* Nothing is changed unless asked: createIndex() builds one suggestion, and
+* setAutoCreate(true) builds each as it is found.  The column extraction is
+* a lightweight tokenizer, not a full SQL parser; treat the output as
+* advice.
+*
+-->
+gamzia::IndexAdvisor advisor = gamzia::IndexAdvisor(db);
+advisor.analyze(*profiler);                 // every profiled statement
+std::cout << advisor.getReport();
+
+for (gamzia::IndexSuggestion& s : advisor.getSuggestions())
+   if (s.frequency > 1000)
+      advisor.createIndex(s);
+<--
+*/
+
+#include "IndexAdvisor.h"
+#include <algorithm>
+#include <sstream>
+#include <limits>
+#include <cctype>
+
+
+/// <summary>
+/// Constructor.
+/// </summary>
+/// <param name="db">An open database; used for EXPLAIN and schema lookups.</param>
+gamzia::IndexAdvisor::IndexAdvisor(Sqlite& db)
+   : mydb(db)
+{
+   isAutoCreate = false;
+}
+
+/// <summary>
+/// Explains one statement and records any index it is missing.
+/// '?' parameters may be left unbound.
+/// </summary>
+/// <param name="sql">The statement.</param>
+/// <param name="calls">How often it runs; used to rank suggestions.</param>
+/// <returns>False if the statement could not be explained.</returns>
+bool gamzia::IndexAdvisor::analyze(const std::string& sql, unsigned long long calls)
+{
+   struct Candidate
+   {
+      std::string table;
+      std::vector<std::string> columns;
+      std::vector<std::string> extra;
+      std::string reason;
+   };
+   std::vector<Candidate> candidates;
+   std::vector<std::string> plan;
+
+   if (mydb.getHandle() == nullptr)
+      return false;
+   myerror.clear();
+   plan = explain(sql);
+   if (!myerror.empty())
+      return false;
+
+   Parsed parsed = parse(tokenize(sql));
+
+   for (const std::string& step : plan)
+   {
+      Candidate candidate;
+
+      if (step.rfind("SCAN ", 0) == 0 && step.find(' ', 5) == std::string::npos)
+      {
+         // Full scan: index the WHERE columns of that table
+         std::string alias = step.substr(5);
+         auto found = parsed.aliases.find(toUpper(alias));
+         candidate.table = (found == parsed.aliases.end() ? alias : found->second);
+         candidate.columns = resolve(parsed.equalities, alias, candidate.table);
+         std::vector<std::string> ranges = resolve(parsed.ranges, alias, candidate.table);
+         if (!ranges.empty())
+            candidate.columns.push_back(ranges[0]);
+         candidate.reason = "full scan";
+      }
+      else if (step.rfind("SEARCH ", 0) == 0 && step.find("USING AUTOMATIC") != std::string::npos)
+      {
+         // SQLite already worked out the columns: "(x=? AND y>?)"
+         std::string alias = step.substr(7, step.find(' ', 7) - 7);
+         auto found = parsed.aliases.find(toUpper(alias));
+         candidate.table = (found == parsed.aliases.end() ? alias : found->second);
+         size_t open = step.find('(');
+         size_t close = step.rfind(')');
+         if (open == std::string::npos || close == std::string::npos || close < open)
+            continue;
+         std::string terms = step.substr(open + 1, close - open - 1);
+         size_t pos = 0;
+         while (pos < terms.size())
+         {
+            size_t end = terms.find(" AND ", pos);
+            std::string term = terms.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+            candidate.columns.push_back(term.substr(0, term.find_first_of("=<>")));
+            pos = (end == std::string::npos ? terms.size() : end + 5);
+         }
+         candidate.reason = "automatic index";
+      }
+      else if (step.rfind("USE TEMP B-TREE FOR ", 0) == 0)
+      {
+         // A sort: index the equality columns, then the sort key
+         std::string what = step.substr(20);
+         const std::vector<Column>& key = (what.find("GROUP BY") != std::string::npos ? parsed.groupBy :
+            what.find("DISTINCT") != std::string::npos ? parsed.selected : parsed.orderBy);
+         candidate.table = findTable(parsed, key);
+         if (candidate.table.empty())
+            continue;
+         candidate.columns = resolve(parsed.equalities, "", candidate.table);
+         for (const std::string& column : resolve(key, "", candidate.table))
+         {
+            if (std::find(candidate.columns.begin(), candidate.columns.end(), column) == candidate.columns.end())
+               candidate.columns.push_back(column);
+         }
+         candidate.reason = "temp b-tree (" + what + ")";
+      }
+
+      if (candidate.columns.empty() || getTableColumns(candidate.table).empty())
+         continue;
+
+      // Covering: a short, plain select list on the same table
+      if (!parsed.selectsAll && !parsed.selected.empty() && findTable(parsed, parsed.selected) == candidate.table)
+         candidate.extra = resolve(parsed.selected, "", candidate.table);
+      candidates.push_back(candidate);
+   }
+
+   // Within a statement, (a) is redundant next to (a, b) on the same table
+   for (size_t i = 0; i < candidates.size(); i++)
+   {
+      bool redundant = false;
+      for (size_t j = 0; j < candidates.size() && !redundant; j++)
+      {
+         const std::vector<std::string>& a = candidates[i].columns;
+         const std::vector<std::string>& b = candidates[j].columns;
+         redundant = (i != j && candidates[i].table == candidates[j].table && a.size() < b.size() &&
+            std::equal(a.begin(), a.end(), b.begin()));
+      }
+      if (!redundant)
+         suggest(sql, calls, candidates[i].table, candidates[i].columns, candidates[i].extra, candidates[i].reason);
+   }
+   return true;
+}
+
+/// <summary>
+/// Analyzes every statement the profiler has recorded, weighted by its
+/// call count.
+/// </summary>
+/// <param name="profiler">A profiler attached to this database.</param>
+/// <returns>The number of statements explained.</returns>
+size_t gamzia::IndexAdvisor::analyze(QueryProfiler& profiler)
+{
+   size_t count = 0;
+
+   for (const QueryProfile& profile : profiler.getTop(std::numeric_limits<size_t>::max()))
+   {
+      // Only plain statements can be explained
+      std::string head = toUpper(profile.sql.substr(0, 8));
+      if (head.rfind("EXPLAIN", 0) == 0 || head.rfind("PRAGMA", 0) == 0)
+         continue;
+      if (analyze(profile.sql, profile.calls))
+         count++;
+   }
+   return (count);
+}
+
+/// <summary>
+/// Returns the suggestions, most used first.  A suggestion whose columns
+/// are a prefix of another on the same table is folded into it, since the
+/// longer index serves both.
+/// </summary>
+std::vector<gamzia::IndexSuggestion> gamzia::IndexAdvisor::getSuggestions()
+{
+   std::vector<IndexSuggestion> all;
+   std::vector<IndexSuggestion> kept;
+
+   for (const auto& entry : mysuggestions)
+      all.push_back(entry.second);
+
+   // Longest first, so a prefix always finds the index that covers it
+   std::sort(all.begin(), all.end(), [](const IndexSuggestion& a, const IndexSuggestion& b)
+      { return a.columns.size() > b.columns.size(); });
+   for (IndexSuggestion& s : all)
+   {
+      IndexSuggestion* target = nullptr;
+      for (IndexSuggestion& k : kept)
+      {
+         if (k.table == s.table && std::equal(s.columns.begin(), s.columns.end(), k.columns.begin()))
+         {
+            target = &k;
+            break;
+         }
+      }
+
+      if (target == nullptr)
+      {
+         kept.push_back(s);
+         continue;
+      }
+      target->frequency += s.frequency;
+      if (target->reason.find(s.reason) == std::string::npos)
+         target->reason += ", " + s.reason;
+      for (const std::string& sql : s.statements)
+      {
+         if (target->statements.size() < MAX_STATEMENTS &&
+            std::find(target->statements.begin(), target->statements.end(), sql) == target->statements.end())
+            target->statements.push_back(sql);
+      }
+   }
+
+   std::stable_sort(kept.begin(), kept.end(), [](const IndexSuggestion& a, const IndexSuggestion& b)
+      { return a.frequency > b.frequency; });
+   return (kept);
+}
+
+/// <summary>
+/// A plain text report: one block per suggestion, most used first.
+/// </summary>
+std::string gamzia::IndexAdvisor::getReport()
+{
+   std::stringstream ss;
+
+   for (const IndexSuggestion& s : getSuggestions())
+   {
+      ss << s.frequency << " executions  " << s.createSql << ";" << (s.created ? "  -- created" : "") << "\n";
+      ss << "   reason: " << s.reason << (s.covering ? ", covering" : "") << "\n";
+      for (const std::string& sql : s.statements)
+         ss << "   e.g.: " << sql << "\n";
+   }
+   return (ss.str());
+}
+
+/// <summary>
+/// Creates a suggested index (CREATE INDEX IF NOT EXISTS).
+/// </summary>
+/// <param name="suggestion">A suggestion from getSuggestions().</param>
+/// <returns>True on success.</returns>
+bool gamzia::IndexAdvisor::createIndex(const IndexSuggestion& suggestion)
+{
+   sqlite3* handle = mydb.getHandle();
+   if (handle == nullptr)
+      return false;
+
+   if (sqlite3_exec(handle, suggestion.createSql.c_str(), NULL, NULL, NULL) != SQLITE_OK)
+   {
+      myerror = sqlite3_errmsg(handle);
+      return false;
+   }
+
+   for (auto& entry : mysuggestions)
+   {
+      if (entry.second.createSql == suggestion.createSql)
+         entry.second.created = true;
+   }
+   return true;
+}
+
+/// <summary>
+/// When on, every new suggestion is created as soon as it is found.
+/// Off by default.
+/// </summary>
+void gamzia::IndexAdvisor::setAutoCreate(bool autoCreate)
+{
+   isAutoCreate = autoCreate;
+}
+
+/// <summary>
+/// Forgets all suggestions and cached schema.
+/// </summary>
+void gamzia::IndexAdvisor::reset()
+{
+   mysuggestions.clear();
+   mytables.clear();
+}
+
+std::string gamzia::IndexAdvisor::getLastError()
+{
+   return (myerror);
+}
+
+/// <summary>
+/// Runs EXPLAIN QUERY PLAN and returns the detail column of each step.
+/// Uses the raw handle, so the statements stay out of the statement cache
+/// and any attached profiler.
+/// </summary>
+std::vector<std::string> gamzia::IndexAdvisor::explain(const std::string& sql)
+{
+   std::vector<std::string> plan;
+   sqlite3_stmt* statement = nullptr;
+   sqlite3* handle = mydb.getHandle();
+   std::string query = "EXPLAIN QUERY PLAN " + sql;
+
+   if (sqlite3_prepare_v2(handle, query.c_str(), -1, &statement, NULL) != SQLITE_OK)
+   {
+      myerror = sqlite3_errmsg(handle);
+      sqlite3_finalize(statement);
+      return (plan);
+   }
+
+   while (sqlite3_step(statement) == SQLITE_ROW)
+   {
+      const unsigned char* detail = sqlite3_column_text(statement, 3);
+      if (detail != nullptr)
+         plan.push_back((const char*)detail);
+   }
+   sqlite3_finalize(statement);
+   return (plan);
+}
+
+/// <summary>
+/// Records (or adds to) a suggestion.
+/// </summary>
+void gamzia::IndexAdvisor::suggest(const std::string& sql, unsigned long long calls, const std::string& table,
+   std::vector<std::string> columns, std::vector<std::string> extra, const std::string& reason)
+{
+   std::string name;
+   std::string list;
+   bool covering = false;
+
+   if (toUpper(table).rfind("SQLITE_", 0) == 0)
+      return;
+   if (columns.size() > MAX_INDEX_COLUMNS)
+      columns.resize(MAX_INDEX_COLUMNS);
+
+   // Append the selected columns if the whole index stays small
+   std::vector<std::string> withExtra = columns;
+   for (const std::string& column : extra)
+   {
+      if (std::find(withExtra.begin(), withExtra.end(), column) == withExtra.end())
+         withExtra.push_back(column);
+   }
+   if (!extra.empty() && withExtra.size() <= MAX_INDEX_COLUMNS)
+   {
+      covering = true;
+      columns = withExtra;
+   }
+
+   name = "idx_" + table;
+   for (const std::string& column : columns)
+   {
+      name += "_" + column;
+      list += (list.empty() ? "" : ", ") + quote(column);
+   }
+
+   std::string key = toUpper(table + "(" + list + ")");
+   auto found = mysuggestions.find(key);
+   if (found == mysuggestions.end())
+   {
+      IndexSuggestion s = IndexSuggestion();
+      s.table = table;
+      s.columns = columns;
+      s.createSql = "CREATE INDEX IF NOT EXISTS " + quote(name) + " ON " + quote(table) + " (" + list + ")";
+      s.reason = reason;
+      s.covering = covering;
+      found = mysuggestions.emplace(key, s).first;
+   }
+
+   IndexSuggestion& s = found->second;
+   s.frequency += calls;
+   if (s.reason.find(reason) == std::string::npos)
+      s.reason += ", " + reason;
+   if (s.statements.size() < MAX_STATEMENTS && std::find(s.statements.begin(), s.statements.end(), sql) == s.statements.end())
+      s.statements.push_back(sql);
+
+   if (isAutoCreate && !s.created)
+      createIndex(s);
+}
+
+/// <summary>
+/// Column names of a table, as declared; empty for views and unknown
+/// tables.  Cached.
+/// </summary>
+const std::vector<std::string>& gamzia::IndexAdvisor::getTableColumns(const std::string& table)
+{
+   std::string key = toUpper(table);
+   auto found = mytables.find(key);
+   if (found != mytables.end())
+      return (found->second);
+
+   std::vector<std::string>& columns = mytables[key];
+   sqlite3_stmt* statement = nullptr;
+   sqlite3* handle = mydb.getHandle();
+   if (handle != nullptr && sqlite3_prepare_v2(handle, "SELECT name FROM pragma_table_info(?)", -1, &statement, NULL) == SQLITE_OK)
+   {
+      sqlite3_bind_text(statement, 1, table.c_str(), (int)table.size(), SQLITE_TRANSIENT);
+      while (sqlite3_step(statement) == SQLITE_ROW)
+         columns.push_back((const char*)sqlite3_column_text(statement, 0));
+   }
+   sqlite3_finalize(statement);
+   return (columns);
+}
+
+/// <summary>
+/// Picks the columns that belong to table: qualified by its alias or name,
+/// or unqualified and declared in it.  Returns declared names, in order,
+/// without duplicates.
+/// </summary>
+std::vector<std::string> gamzia::IndexAdvisor::resolve(const std::vector<Column>& columns,
+   const std::string& alias, const std::string& table)
+{
+   std::vector<std::string> result;
+   const std::vector<std::string>& declared = getTableColumns(table);
+
+   for (const Column& column : columns)
+   {
+      if (!column.qualifier.empty())
+      {
+         std::string qualifier = toUpper(column.qualifier);
+         if (qualifier != toUpper(table) && (alias.empty() || qualifier != toUpper(alias)))
+            continue;
+      }
+
+      for (const std::string& name : declared)
+      {
+         if (toUpper(name) == toUpper(column.name) &&
+            std::find(result.begin(), result.end(), name) == result.end())
+            result.push_back(name);
+      }
+   }
+   return (result);
+}
+
+/// <summary>
+/// The single table all of columns belong to, via their qualifiers or the
+/// tables in the statement; empty if none or ambiguous.
+/// </summary>
+std::string gamzia::IndexAdvisor::findTable(const Parsed& parsed, const std::vector<Column>& columns)
+{
+   std::set<std::string> tables;
+   std::string result;
+
+   for (const auto& alias : parsed.aliases)
+      tables.insert(alias.second);
+
+   for (const Column& column : columns)
+   {
+      std::string owner;
+      if (!column.qualifier.empty())
+      {
+         auto found = parsed.aliases.find(toUpper(column.qualifier));
+         if (found == parsed.aliases.end())
+            return "";
+         owner = found->second;
+      }
+      else
+      {
+         for (const std::string& table : tables)
+         {
+            if (!resolve({ column }, "", table).empty())
+            {
+               if (!owner.empty())
+                  return "";
+               owner = table;
+            }
+         }
+      }
+
+      if (owner.empty() || (!result.empty() && toUpper(owner) != toUpper(result)))
+         return "";
+      result = owner;
+   }
+   return (result);
+}
+
+/// <summary>
+/// Splits SQL into identifiers, literals and symbols.  Literals and
+/// parameters are reduced to placeholders; comments are dropped.
+/// </summary>
+std::vector<gamzia::IndexAdvisor::Token> gamzia::IndexAdvisor::tokenize(const std::string& sql)
+{
+   std::vector<Token> tokens;
+   size_t i = 0;
+
+   while (i < sql.size())
+   {
+      unsigned char c = (unsigned char)sql[i];
+      Token token = Token();
+
+      if (isspace(c))
+      {
+         i++;
+         continue;
+      }
+      if (sql.compare(i, 2, "--") == 0)
+      {
+         i = sql.find('\n', i);
+         i = (i == std::string::npos ? sql.size() : i);
+         continue;
+      }
+      if (sql.compare(i, 2, "/*") == 0)
+      {
+         i = sql.find("*/", i + 2);
+         i = (i == std::string::npos ? sql.size() : i + 2);
+         continue;
+      }
+
+      if (c == '\'')
+      {
+         // 'It''s' is one literal
+         for (i++; i < sql.size(); i++)
+         {
+            if (sql[i] == '\'' && (i + 1 >= sql.size() || sql[i + 1] != '\''))
+               break;
+            if (sql[i] == '\'')
+               i++;
+         }
+         i++;
+         token.text = "'";
+      }
+      else if (c == '"' || c == '`' || c == '[')
+      {
+         char close = (c == '[' ? ']' : (char)c);
+         size_t end = sql.find(close, i + 1);
+         end = (end == std::string::npos ? sql.size() : end);
+         token.text = sql.substr(i + 1, end - i - 1);
+         token.isIdentifier = true;
+         i = end + 1;
+      }
+      else if (isalpha(c) || c == '_')
+      {
+         size_t start = i;
+         while (i < sql.size() && (isalnum((unsigned char)sql[i]) || sql[i] == '_' || sql[i] == '$'))
+            i++;
+         token.text = sql.substr(start, i - start);
+         token.isIdentifier = true;
+      }
+      else if (isdigit(c))
+      {
+         while (i < sql.size() && (isalnum((unsigned char)sql[i]) || sql[i] == '.'))
+            i++;
+         token.text = "0";
+      }
+      else if (c == '?' || c == ':' || c == '@' || c == '$')
+      {
+         for (i++; i < sql.size() && (isalnum((unsigned char)sql[i]) || sql[i] == '_'); i++)
+            ;
+         token.text = "?";
+      }
+      else
+      {
+         static const char* pairs[] = { "<=", ">=", "==", "!=", "<>", "||" };
+         token.text = sql.substr(i, 1);
+         for (const char* pair : pairs)
+         {
+            if (sql.compare(i, 2, pair) == 0)
+               token.text = pair;
+         }
+         i += token.text.size();
+      }
+
+      token.upper = toUpper(token.text);
+      tokens.push_back(token);
+   }
+   return (tokens);
+}
+
+/// <summary>
+/// Extracts what the advisor needs from the tokens: table aliases, WHERE /
+/// ON constraints, ORDER BY, GROUP BY and a plain select list.
+/// </summary>
+gamzia::IndexAdvisor::Parsed gamzia::IndexAdvisor::parse(const std::vector<Token>& tokens)
+{
+   Parsed parsed = Parsed();
+   bool inWhere = false;
+   bool sawSelect = false;
+   size_t i = 0;
+
+   while (i < tokens.size())
+   {
+      const std::string& word = tokens[i].upper;
+      bool hasBy = (i + 1 < tokens.size() && tokens[i + 1].upper == "BY");
+
+      if (word == "FROM" || word == "JOIN" || word == "UPDATE" || word == "INTO")
+      {
+         // table [AS alias] [, table [AS alias] ...]
+         size_t j = i + 1;
+         while (j < tokens.size() && tokens[j].isIdentifier && !isKeyword(tokens[j].upper))
+         {
+            std::string table = tokens[j].text;
+            if (j + 2 < tokens.size() && tokens[j + 1].text == "." && tokens[j + 2].isIdentifier)
+            {
+               table = tokens[j + 2].text;
+               j += 2;
+            }
+            parsed.aliases[toUpper(table)] = table;
+            j++;
+            if (j < tokens.size() && tokens[j].upper == "AS")
+               j++;
+            if (j < tokens.size() && tokens[j].isIdentifier && !isKeyword(tokens[j].upper))
+               parsed.aliases[tokens[j++].upper] = table;
+            if (word != "FROM" || j >= tokens.size() || tokens[j].text != ",")
+               break;
+            j++;
+         }
+         i++;
+         continue;
+      }
+
+      if (word == "WHERE" || word == "ON")
+         inWhere = true;
+      else if (word == "ORDER" || word == "GROUP" || word == "LIMIT" || word == "HAVING" || word == "SET" ||
+         word == "RETURNING" || word == "WINDOW" || word == "UNION" || word == "EXCEPT" || word == "INTERSECT")
+         inWhere = false;
+
+      if ((word == "ORDER" || word == "GROUP") && hasBy)
+      {
+         i += 2;
+         std::vector<Column> list = readColumnList(tokens, i);
+         (word == "ORDER" ? parsed.orderBy : parsed.groupBy) = list;
+         continue;
+      }
+
+      if (word == "SELECT" && !sawSelect)
+      {
+         sawSelect = true;
+         i++;
+         if (i < tokens.size() && (tokens[i].upper == "DISTINCT" || tokens[i].upper == "ALL"))
+            i++;
+         if (i < tokens.size() && tokens[i].text == "*")
+            parsed.selectsAll = true;
+         else if (i + 2 < tokens.size() && tokens[i + 1].text == "." && tokens[i + 2].text == "*")
+            parsed.selectsAll = true;
+         else
+         {
+            parsed.selected = readColumnList(tokens, i);
+            if (i >= tokens.size() || tokens[i].upper != "FROM")
+               parsed.selected.clear();
+         }
+         continue;
+      }
+
+      // [qualifier.]column OP ...
+      if (inWhere && tokens[i].isIdentifier && !isKeyword(word) && (i == 0 || tokens[i - 1].text != "."))
+      {
+         Column column = Column();
+         size_t next = i + 1;
+         column.name = tokens[i].text;
+         if (next + 1 < tokens.size() && tokens[next].text == "." && tokens[next + 1].isIdentifier)
+         {
+            column.qualifier = tokens[i].text;
+            column.name = tokens[next + 1].text;
+            next += 2;
+         }
+
+         std::string op = (next < tokens.size() ? tokens[next].upper : "");
+         bool negated = (next + 1 < tokens.size() && tokens[next + 1].upper == "NOT");
+         if (op == "=" || op == "==" || op == "IN" || (op == "IS" && !negated))
+            parsed.equalities.push_back(column);
+         else if (op == "<" || op == "<=" || op == ">" || op == ">=" || op == "BETWEEN")
+            parsed.ranges.push_back(column);
+         i = next;
+         continue;
+      }
+
+      i++;
+   }
+   return (parsed);
+}
+
+/// <summary>
+/// Reads "[q.]col [COLLATE x] [ASC|DESC] [NULLS FIRST|LAST] [AS y], ...".
+/// Returns an empty list if any item is an expression.
+/// </summary>
+std::vector<gamzia::IndexAdvisor::Column> gamzia::IndexAdvisor::readColumnList(const std::vector<Token>& tokens, size_t& i)
+{
+   std::vector<Column> columns;
+
+   while (i < tokens.size())
+   {
+      Column column = Column();
+      if (!tokens[i].isIdentifier || isKeyword(tokens[i].upper))
+         return (std::vector<Column>());
+
+      column.name = tokens[i].text;
+      i++;
+      if (i + 1 < tokens.size() && tokens[i].text == "." && tokens[i + 1].isIdentifier)
+      {
+         column.qualifier = column.name;
+         column.name = tokens[i + 1].text;
+         i += 2;
+      }
+
+      while (i < tokens.size())
+      {
+         const std::string& word = tokens[i].upper;
+         if (word == "COLLATE" || word == "NULLS" || word == "AS")
+            i += 2;
+         else if (word == "ASC" || word == "DESC")
+            i++;
+         else
+            break;
+      }
+      columns.push_back(column);
+
+      if (i >= tokens.size() || tokens[i].text != ",")
+         break;
+      i++;
+   }
+
+   // Anything but the end of the clause means an expression
+   if (i < tokens.size() && !isKeyword(tokens[i].upper) && tokens[i].text != ")" && tokens[i].text != ";")
+      return (std::vector<Column>());
+   return (columns);
+}
+
+bool gamzia::IndexAdvisor::isKeyword(const std::string& upper)
+{
+   static const std::set<std::string> keywords = {
+      "ALL", "AND", "AS", "ASC", "BETWEEN", "BY", "CASE", "CAST", "COLLATE", "CROSS", "DEFAULT",
+      "DELETE", "DESC", "DISTINCT", "ELSE", "END", "ESCAPE", "EXCEPT", "EXISTS", "FIRST", "FROM",
+      "FULL", "GLOB", "GROUP", "HAVING", "IN", "INDEXED", "INNER", "INSERT", "INTERSECT", "INTO",
+      "IS", "JOIN", "LAST", "LEFT", "LIKE", "LIMIT", "MATCH", "NATURAL", "NOT", "NULL", "NULLS",
+      "OFFSET", "ON", "OR", "ORDER", "OUTER", "REGEXP", "REPLACE", "RETURNING", "RIGHT", "SELECT",
+      "SET", "THEN", "UNION", "UPDATE", "USING", "VALUES", "WHEN", "WHERE", "WINDOW"
+   };
+   return (keywords.count(upper) > 0);
+}
+
+std::string gamzia::IndexAdvisor::quote(const std::string& identifier)
+{
+   std::string quoted = "\"";
+   for (char c : identifier)
+      quoted += (c == '"' ? std::string("\"\"") : std::string(1, c));
+   return (quoted + "\"");
+}
+
+std::string gamzia::IndexAdvisor::toUpper(std::string text)
+{
+   for (char& c : text)
+      c = (char)toupper((unsigned char)c);
+   return (text);
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include "Sqlite.h"
+#include "QueryProfiler.h"
+
+namespace gamzia
+{
+
+   struct IndexSuggestion
+   {
+      std::string table;
+      std::vector<std::string> columns;
+      std::string createSql;
+      std::string reason;                 // ie: "full scan", "temp b-tree (ORDER BY)"
+      bool covering;
+      bool created;
+      unsigned long long frequency;       // executions that would use it
+      std::vector<std::string> statements;
+   };
+
+   class IndexAdvisor
+   {
+
+   public:
+      IndexAdvisor(Sqlite& db);
+
+      bool analyze(const std::string& sql, unsigned long long calls = 1);
+      size_t analyze(QueryProfiler& profiler);
+      std::vector<IndexSuggestion> getSuggestions();
+      std::string getReport();
+      bool createIndex(const IndexSuggestion& suggestion);
+      void setAutoCreate(bool autoCreate);
+      void reset();
+      std::string getLastError();
+
+      inline static const size_t MAX_INDEX_COLUMNS = 5;
+      inline static const size_t MAX_STATEMENTS = 3;
+
+   private:
+      struct Token
+      {
+         std::string text;
+         std::string upper;
+         bool isIdentifier;
+      };
+
+      struct Column
+      {
+         std::string qualifier;
+         std::string name;
+      };
+
+      struct Parsed
+      {
+         std::map<std::string, std::string> aliases;   // upper alias -> table
+         std::vector<Column> equalities;
+         std::vector<Column> ranges;
+         std::vector<Column> orderBy;
+         std::vector<Column> groupBy;
+         std::vector<Column> selected;
+         bool selectsAll;
+      };
+
+      Sqlite& mydb;
+      bool isAutoCreate;
+      std::string myerror;
+      std::map<std::string, IndexSuggestion> mysuggestions;
+      std::map<std::string, std::vector<std::string>> mytables;
+
+      std::vector<std::string> explain(const std::string& sql);
+      void suggest(const std::string& sql, unsigned long long calls, const std::string& table,
+         std::vector<std::string> columns, std::vector<std::string> extra, const std::string& reason);
+      const std::vector<std::string>& getTableColumns(const std::string& table);
+      std::vector<std::string> resolve(const std::vector<Column>& columns, const std::string& alias,
+         const std::string& table);
+      std::string findTable(const Parsed& parsed, const std::vector<Column>& columns);
+
+      static std::vector<Token> tokenize(const std::string& sql);
+      static Parsed parse(const std::vector<Token>& tokens);
+      static std::vector<Column> readColumnList(const std::vector<Token>& tokens, size_t& i);
+      static bool isKeyword(const std::string& upper);
+      static std::string quote(const std::string& identifier);
+      static std::string toUpper(std::string text);
+   }; // class
+
+}; // namespace
@@ -0,0 +1,277 @@
+/*
+* Class MaintenanceScheduler
+* ==========================
+*
+* Background housekeeping for an Sqlite database, on its own connection and
+* thread, in small pieces and when nobody else is writing.
+*
+* A full VACUUM rewrites the whole file and locks everyone out while it does;
+* run after each delete, a purge of many rows costs a rewrite per row.  With
+* auto_vacuum=INCREMENTAL (Sqlite::setAutoVacuum()) deletes leave their pages
+* on the file's free list instead, and this class hands them back to the
+* file system with PRAGMA incremental_vacuum, at most pagesPerRun pages per
+* check: a short write transaction that other writers barely notice.
+*
+* Every interval it checks PRAGMA data_version: when no other connection has
+* committed for idleChecks checks in a row, the database counts as idle and
+* free pages are reclaimed.  If the free list grows past freePageThreshold,
+* pages are reclaimed anyway, still pagesPerRun at a time.  When idle, and
+* at most once per optimizeInterval, it also runs PRAGMA optimize (or a full
+* ANALYZE) so the query planner's statistics follow the data.
+*
+* Its connection waits at most busyTimeout for a lock; a check that finds the
+* database locked is counted as busy and tried again next time.  The database
+* must be a file (a ":memory:" one is private to the connection that made it),
+* and auto_vacuum must be INCREMENTAL before the scheduler opens it, or only
+* the optimizing is done.
+*
+-->
+gamzia::Sqlite db = gamzia::Sqlite("accounts.db");
+db.connect();
+db.setAutoVacuum("incremental");      // once; converts an existing file
+
+gamzia::MaintenanceScheduler maintenance = gamzia::MaintenanceScheduler("accounts.db");
+maintenance.start();
+// ... deletes, purges ...
+std::cout << maintenance.getStats().pagesReclaimed << std::endl;
+<--
+*/
+
+#include "MaintenanceScheduler.h"
+
+
+/// <summary>
+/// Constructor; opens its own connection to dbname.  Call start() to run
+/// the checks in the background, or check() to run one.
+/// </summary>
+/// <param name="dbname">An existing database file.</param>
+/// <param name="options">When and how much to do.</param>
+gamzia::MaintenanceScheduler::MaintenanceScheduler(std::string dbname, MaintenanceOptions options)
+   : mydb(dbname)
+{
+   std::vector<std::string> row;
+
+   myoptions = options;
+   myversion = -1;
+   myquiet = 0;
+   mylastoptimize = std::chrono::steady_clock::now();
+   mystats = MaintenanceStats();
+   isStopping = false;
+   isIncrementalFlag = false;
+
+   if (!mydb.connect(SQLITE_OPEN_READWRITE) || !mydb.setBusyTimeout(myoptions.busyTimeout))
+   {
+      isReadyFlag = false;
+      myerror = mydb.getLastError();
+      return;
+   }
+
+   // 2: INCREMENTAL
+   gamzia::Cursor k = mydb.getCursor();
+   if (k.execute("PRAGMA auto_vacuum"))
+      row = k.fetchOne();
+   isIncrementalFlag = (!row.empty() && row[0] == "2");
+   if (!isIncrementalFlag)
+      myerror = "auto_vacuum is not INCREMENTAL; free pages are not reclaimed";
+   myversion = mydb.getDataVersion();
+   isReadyFlag = true;
+}
+
+gamzia::MaintenanceScheduler::~MaintenanceScheduler()
+{
+   stop();
+}
+
+bool gamzia::MaintenanceScheduler::isReady()
+{
+   return (isReadyFlag);
+}
+
+std::string gamzia::MaintenanceScheduler::getLastError()
+{
+   std::lock_guard<std::mutex> guard(mylock);
+   return (myerror);
+}
+
+/// <summary>
+/// Calls check() every interval on a background thread, until stop() or
+/// destruction.  Restarts the thread if already running.
+/// </summary>
+void gamzia::MaintenanceScheduler::start()
+{
+   stop();
+   {
+      std::lock_guard<std::mutex> guard(mylock);
+      isStopping = false;
+   }
+   myworker = std::thread(&MaintenanceScheduler::run, this);
+}
+
+void gamzia::MaintenanceScheduler::stop()
+{
+   {
+      std::lock_guard<std::mutex> guard(mylock);
+      isStopping = true;
+   }
+   mywake.notify_one();
+   if (myworker.joinable())
+      myworker.join();
+}
+
+/// <summary>
+/// One round: reclaims free pages and optimizes, if due (see
+/// MaintenanceOptions).  Called by the background thread.
+/// </summary>
+/// <returns>False if something that was due failed or found the database busy.</returns>
+bool gamzia::MaintenanceScheduler::check()
+{
+   std::lock_guard<std::mutex> working(myworklock);
+   bool ok = true;
+
+   if (!isReadyFlag)
+      return false;
+
+   // Our own commits do not change data_version; anyone else's do
+   long long version = mydb.getDataVersion();
+   myquiet = (version == myversion ? myquiet + 1 : 0);
+   myversion = version;
+   bool isIdle = (myquiet >= myoptions.idleChecks);
+   {
+      std::lock_guard<std::mutex> guard(mylock);
+      mystats.checks++;
+   }
+
+   if (isIncrementalFlag)
+   {
+      long long free = mydb.getFreePages();
+      if (free > 0 && (isIdle || free >= myoptions.freePageThreshold))
+         ok = reclaimPages(myoptions.pagesPerRun);
+   }
+
+   if (isIdle && myoptions.optimizeInterval.count() > 0 &&
+      std::chrono::steady_clock::now() - mylastoptimize >= myoptions.optimizeInterval)
+      ok = optimizeNow() && ok;
+
+   return (ok);
+}
+
+/// <summary>
+/// Reclaims free pages now, whatever the schedule; ie, right after a purge.
+/// </summary>
+/// <param name="pages">Upper bound on pages freed; 0 for all.</param>
+/// <returns>True on success.</returns>
+bool gamzia::MaintenanceScheduler::reclaim(int pages)
+{
+   std::lock_guard<std::mutex> working(myworklock);
+   if (!isReadyFlag)
+      return false;
+   return (reclaimPages(pages));
+}
+
+/// <summary>
+/// Runs PRAGMA optimize (or ANALYZE, per the options) now.
+/// </summary>
+/// <returns>True on success.</returns>
+bool gamzia::MaintenanceScheduler::optimize()
+{
+   std::lock_guard<std::mutex> working(myworklock);
+   if (!isReadyFlag)
+      return false;
+   return (optimizeNow());
+}
+
+/// <summary>
+/// Pages on the database's free list, as seen by the scheduler's connection.
+/// </summary>
+/// <returns>The count, or -1 on error.</returns>
+long long gamzia::MaintenanceScheduler::getFreePages()
+{
+   std::lock_guard<std::mutex> working(myworklock);
+   return (mydb.getFreePages());
+}
+
+gamzia::MaintenanceStats gamzia::MaintenanceScheduler::getStats()
+{
+   std::lock_guard<std::mutex> guard(mylock);
+   return (mystats);
+}
+
+/// <summary>
+/// Runs one incremental vacuum; myworklock held.
+/// </summary>
+bool gamzia::MaintenanceScheduler::reclaimPages(int pages)
+{
+   std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+   long long before = mydb.getFreePages();
+
+   gamzia::Cursor k = mydb.getCursor();
+   if (!k.incrementalVacuum(pages))
+   {
+      fail();
+      return false;
+   }
+   long long after = mydb.getFreePages();
+
+   std::lock_guard<std::mutex> guard(mylock);
+   mystats.reclaims++;
+   if (before > after)
+      mystats.pagesReclaimed += (unsigned long long)(before - after);
+   mystats.lastRunMicros = (unsigned long long)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start).count();
+   return true;
+}
+
+/// <summary>
+/// Runs PRAGMA optimize or ANALYZE; myworklock held.
+/// </summary>
+bool gamzia::MaintenanceScheduler::optimizeNow()
+{
+   std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+   // Not retried before the next interval, even if it fails
+   mylastoptimize = start;
+   gamzia::Cursor k = mydb.getCursor();
+   if (!(myoptions.analyze ? k.analyze() : k.optimize()))
+   {
+      fail();
+      return false;
+   }
+
+   std::lock_guard<std::mutex> guard(mylock);
+   mystats.optimizes++;
+   mystats.lastRunMicros = (unsigned long long)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start).count();
+   return true;
+}
+
+/// <summary>
+/// Counts a failed task: busy if another connection held the lock (it is
+/// simply tried again later), a failure otherwise.
+/// </summary>
+void gamzia::MaintenanceScheduler::fail()
+{
+   int rc = sqlite3_errcode(mydb.getHandle());
+
+   std::lock_guard<std::mutex> guard(mylock);
+   myerror = sqlite3_errmsg(mydb.getHandle());
+   if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
+      mystats.busy++;
+   else
+      mystats.failures++;
+}
+
+/// <summary>
+/// Background thread.
+/// </summary>
+void gamzia::MaintenanceScheduler::run()
+{
+   for (;;)
+   {
+      {
+         std::unique_lock<std::mutex> guard(mylock);
+         if (mywake.wait_for(guard, myoptions.interval, [this] { return isStopping; }))
+            return;
+      }
+      check();
+   }
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <string>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include "Sqlite.h"
+
+namespace gamzia
+{
+
+   /// <summary>
+   /// Options for MaintenanceScheduler.  A check runs every interval.  Free
+   /// pages are reclaimed, at most pagesPerRun per check, once the database
+   /// has been idle (no commits by others) for idleChecks checks, or at once
+   /// when freePageThreshold pages are free.  PRAGMA optimize (or ANALYZE)
+   /// runs when idle, at most once per optimizeInterval; 0 turns it off.
+   /// </summary>
+   struct MaintenanceOptions
+   {
+      std::chrono::milliseconds interval = std::chrono::seconds(5);
+      int pagesPerRun = 1024;
+      long long freePageThreshold = 16384;
+      int idleChecks = 2;
+      std::chrono::milliseconds optimizeInterval = std::chrono::hours(1);
+      bool analyze = false;
+      int busyTimeout = BUSY_TIMEOUT;
+
+      inline static const int BUSY_TIMEOUT = 100;
+   };
+
+   struct MaintenanceStats
+   {
+      unsigned long long checks;
+      unsigned long long reclaims;        // incremental vacuums run
+      unsigned long long pagesReclaimed;
+      unsigned long long optimizes;
+      unsigned long long busy;            // skipped, the database was locked
+      unsigned long long failures;
+      unsigned long long lastRunMicros;   // last reclaim or optimize
+   };
+
+   class MaintenanceScheduler
+   {
+
+   public:
+      MaintenanceScheduler(std::string dbname, MaintenanceOptions options = MaintenanceOptions());
+      ~MaintenanceScheduler();
+      MaintenanceScheduler(const MaintenanceScheduler&) = delete;
+      MaintenanceScheduler& operator=(const MaintenanceScheduler&) = delete;
+
+      bool isReady();
+      std::string getLastError();
+      void start();
+      void stop();
+      bool check();
+      bool reclaim(int pages);
+      bool optimize();
+      long long getFreePages();
+      MaintenanceStats getStats();
+
+   private:
+      MaintenanceOptions myoptions;
+      bool isReadyFlag;
+      bool isIncrementalFlag;
+      std::string myerror;
+      Sqlite mydb;
+      long long myversion;
+      int myquiet;                        // checks in a row with no commits
+      std::chrono::steady_clock::time_point mylastoptimize;
+      MaintenanceStats mystats;
+
+      std::mutex mylock;                  // mystats, myerror, isStopping
+      std::mutex myworklock;              // mydb, one task at a time
+      std::thread myworker;
+      std::condition_variable mywake;
+      bool isStopping;
+
+      bool reclaimPages(int pages);
+      bool optimizeNow();
+      void fail();
+      void run();
+   }; // class
+
+}; // namespace
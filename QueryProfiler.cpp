@@ -0,0 +1,284 @@
+/*
+* Class QueryProfiler
+* ===================
+*
+* Per statement profiling and a slow query log for the Sqlite wrapper.
+*
+* Attach a profiler to a connection (or to every connection of a pool) and
+* each execution a Cursor performs is recorded under its normalized SQL:
+* literals are replaced by '?' and whitespace is collapsed, so
+* "WHERE id=42" and "WHERE id=7" count as the same statement.  For each one
+* the profiler keeps the call count, rows returned, time spent preparing and
+* stepping, SQLite's own per statement counters (full scan steps, sorts,
+* automatic indexes, VM steps) and a log2 latency histogram.
+*
+* Executions slower than the threshold (SLOW_THRESHOLD us by default) are
+* appended to the slow log, one line each, with the original SQL text.
+*
+* Times cover SQLite's work only: prepare, plus every sqlite3_step made
+* through the cursor, not the caller's processing between rows.  Without a
+* profiler attached, a cursor pays one null check per step.
+*
+-->
+std::shared_ptr<gamzia::QueryProfiler> profiler = std::make_shared<gamzia::QueryProfiler>();
+profiler->setSlowThreshold(50000);           // 50 ms
+profiler->setSlowLog("slow_queries.log");
+db.setProfiler(profiler);
+
+// ... run the workload ...
+
+std::cout << profiler->getReport(10);       // top 10 by total time
+<--
+*/
+
+#include "QueryProfiler.h"
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <ctime>
+#include <cctype>
+
+
+/************************
+*  Struct QueryProfile  *
+************************/
+
+unsigned long long gamzia::QueryProfile::getTotalMicros() const
+{
+   return (prepareMicros + stepMicros);
+}
+
+/// <summary>
+/// Estimates a latency percentile from the histogram; returns the upper
+/// bound of the bucket it falls in, in microseconds.
+/// </summary>
+/// <param name="percent">ie: 50, 95, 99.</param>
+unsigned long long gamzia::QueryProfile::getPercentile(double percent) const
+{
+   unsigned long long target = (unsigned long long)((double)calls * percent / 100.0 + 0.5);
+   unsigned long long seen = 0;
+
+   for (size_t i = 0; i < histogram.size(); i++)
+   {
+      seen += histogram[i];
+      if (seen >= target && seen > 0)
+         return ((unsigned long long)1 << (i + 1));
+   }
+   return (0);
+}
+
+/************************
+*  Class QueryProfiler  *
+************************/
+
+gamzia::QueryProfiler::QueryProfiler()
+{
+   myslowthreshold = SLOW_THRESHOLD;
+   myslowcount = 0;
+}
+
+/// <summary>
+/// Records one execution.  Called by Cursor when it finishes with a
+/// statement (re-executes, moves to other SQL, or is destroyed), before the
+/// statement is reset; reads and clears the statement's status counters.
+/// </summary>
+/// <param name="sql">The SQL as executed.</param>
+/// <param name="prepareMicros">Time to obtain the prepared statement.</param>
+/// <param name="stepMicros">Time spent in sqlite3_step.</param>
+/// <param name="rows">Rows returned.</param>
+/// <param name="statement">The statement, for its status counters.</param>
+void gamzia::QueryProfiler::record(const std::string& sql, unsigned long long prepareMicros,
+   unsigned long long stepMicros, unsigned long long rows, sqlite3_stmt* statement)
+{
+   std::string key = normalize(sql);
+   unsigned long long total = prepareMicros + stepMicros;
+   unsigned long long fullScans = 0, sorts = 0, autoIndexes = 0, vmSteps = 0;
+
+   if (statement != nullptr)
+   {
+      fullScans = (unsigned long long)sqlite3_stmt_status(statement, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1);
+      sorts = (unsigned long long)sqlite3_stmt_status(statement, SQLITE_STMTSTATUS_SORT, 1);
+      autoIndexes = (unsigned long long)sqlite3_stmt_status(statement, SQLITE_STMTSTATUS_AUTOINDEX, 1);
+      vmSteps = (unsigned long long)sqlite3_stmt_status(statement, SQLITE_STMTSTATUS_VM_STEP, 1);
+   }
+
+   std::lock_guard<std::mutex> guard(mylock);
+   QueryProfile& profile = myprofiles[key];
+   if (profile.calls == 0)
+      profile.sql = key;
+   profile.calls++;
+   profile.rows += rows;
+   profile.prepareMicros += prepareMicros;
+   profile.stepMicros += stepMicros;
+   profile.maxMicros = std::max(profile.maxMicros, total);
+   profile.fullScanSteps += fullScans;
+   profile.sorts += sorts;
+   profile.autoIndexes += autoIndexes;
+   profile.vmSteps += vmSteps;
+   profile.histogram[bucketOf(total)]++;
+
+   if (total >= myslowthreshold)
+   {
+      myslowcount++;
+      if (myslowlog.is_open())
+      {
+         myslowlog << time(0) << "\t" << total << "us\t" << rows << " rows\t"
+            << fullScans << " scan steps\t" << sql << "\n";
+         myslowlog.flush();
+      }
+   }
+}
+
+/// <summary>
+/// Returns the most expensive statements, by total time (prepare + step).
+/// </summary>
+/// <param name="count">How many to return.</param>
+std::vector<gamzia::QueryProfile> gamzia::QueryProfiler::getTop(size_t count)
+{
+   std::vector<QueryProfile> top;
+
+   {
+      std::lock_guard<std::mutex> guard(mylock);
+      top.reserve(myprofiles.size());
+      for (const auto& entry : myprofiles)
+         top.push_back(entry.second);
+   }
+
+   std::sort(top.begin(), top.end(), [](const QueryProfile& a, const QueryProfile& b)
+      { return a.getTotalMicros() > b.getTotalMicros(); });
+   if (top.size() > count)
+      top.resize(count);
+   return (top);
+}
+
+/// <summary>
+/// A plain text table of the top statements: total and per call time,
+/// percentiles, rows and SQLite's counters.
+/// </summary>
+/// <param name="count">How many statements to list.</param>
+std::string gamzia::QueryProfiler::getReport(size_t count)
+{
+   std::stringstream ss;
+
+   ss << std::left << std::setw(10) << "total ms" << std::setw(9) << "calls" << std::setw(10) << "avg us"
+      << std::setw(10) << "p95 us" << std::setw(10) << "max us" << std::setw(11) << "rows"
+      << std::setw(11) << "scan steps" << std::setw(7) << "sorts" << std::setw(9) << "autoidx"
+      << "sql\n";
+
+   for (const QueryProfile& p : getTop(count))
+   {
+      ss << std::left << std::setw(10) << p.getTotalMicros() / 1000 << std::setw(9) << p.calls
+         << std::setw(10) << (p.calls == 0 ? 0 : p.getTotalMicros() / p.calls)
+         << std::setw(10) << p.getPercentile(95) << std::setw(10) << p.maxMicros
+         << std::setw(11) << p.rows << std::setw(11) << p.fullScanSteps << std::setw(7) << p.sorts
+         << std::setw(9) << p.autoIndexes << p.sql << "\n";
+   }
+   return (ss.str());
+}
+
+void gamzia::QueryProfiler::reset()
+{
+   std::lock_guard<std::mutex> guard(mylock);
+   myprofiles.clear();
+   myslowcount = 0;
+}
+
+/// <summary>
+/// Executions taking at least this long are counted (and logged, if a
+/// slow log is set).
+/// </summary>
+/// <param name="micros">Threshold in microseconds.</param>
+void gamzia::QueryProfiler::setSlowThreshold(unsigned long long micros)
+{
+   std::lock_guard<std::mutex> guard(mylock);
+   myslowthreshold = micros;
+}
+
+/// <summary>
+/// Appends slow executions to a file (tab separated: time, duration, rows,
+/// full scan steps, SQL).  An empty path stops logging.
+/// </summary>
+/// <param name="path">The log file.</param>
+/// <returns>True if the log is open (or was closed on request).</returns>
+bool gamzia::QueryProfiler::setSlowLog(std::string path)
+{
+   std::lock_guard<std::mutex> guard(mylock);
+   if (myslowlog.is_open())
+      myslowlog.close();
+   if (path.empty())
+      return true;
+
+   myslowlog.open(path, std::ios::out | std::ios::app);
+   return (myslowlog.is_open());
+}
+
+unsigned long long gamzia::QueryProfiler::getSlowCount()
+{
+   std::lock_guard<std::mutex> guard(mylock);
+   return (myslowcount);
+}
+
+/// <summary>
+/// Normalizes SQL for grouping: string and numeric literals become '?',
+/// runs of whitespace become one space.  Identifiers are left alone.
+/// </summary>
+/// <param name="sql">The SQL text.</param>
+/// <returns>The normalized text.</returns>
+std::string gamzia::QueryProfiler::normalize(std::string_view sql)
+{
+   std::string result;
+   size_t i = 0;
+
+   result.reserve(sql.size());
+   while (i < sql.size())
+   {
+      unsigned char c = (unsigned char)sql[i];
+
+      if (isspace(c))
+      {
+         while (i < sql.size() && isspace((unsigned char)sql[i]))
+            i++;
+         if (!result.empty() && i < sql.size())
+            result += ' ';
+      }
+      else if (c == '\'')
+      {
+         // 'It''s' is one literal
+         i++;
+         while (i < sql.size())
+         {
+            if (sql[i] == '\'' && (i + 1 >= sql.size() || sql[i + 1] != '\''))
+               break;
+            i += (sql[i] == '\'' ? 2 : 1);
+         }
+         i++;
+         result += '?';
+      }
+      else if (isdigit(c) && (result.empty() || !(isalnum((unsigned char)result.back()) || result.back() == '_')))
+      {
+         while (i < sql.size() && (isalnum((unsigned char)sql[i]) || sql[i] == '.'))
+            i++;
+         result += '?';
+      }
+      else if (isalpha(c) || c == '_')
+      {
+         // Whole identifiers, so digits inside them stay
+         while (i < sql.size() && (isalnum((unsigned char)sql[i]) || sql[i] == '_'))
+            result += sql[i++];
+      }
+      else
+         result += sql[i++];
+   }
+   return (result);
+}
+
+int gamzia::QueryProfiler::bucketOf(unsigned long long micros)
+{
+   int bucket = 0;
+   while (micros > 1 && bucket < 31)
+   {
+      micros >>= 1;
+      bucket++;
+   }
+   return (bucket);
+}
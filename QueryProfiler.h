@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <mutex>
+#include <fstream>
+#include <cstdint>
+#include "sqlite3.h"
+
+namespace gamzia
+{
+
+   struct QueryProfile
+   {
+      std::string sql;                    // normalized: literals become ?
+      unsigned long long calls;
+      unsigned long long rows;
+      unsigned long long prepareMicros;
+      unsigned long long stepMicros;
+      unsigned long long maxMicros;
+      unsigned long long fullScanSteps;   // SQLITE_STMTSTATUS_FULLSCAN_STEP
+      unsigned long long sorts;           // SQLITE_STMTSTATUS_SORT
+      unsigned long long autoIndexes;     // SQLITE_STMTSTATUS_AUTOINDEX
+      unsigned long long vmSteps;         // SQLITE_STMTSTATUS_VM_STEP
+      std::array<unsigned long long, 32> histogram;   // bucket i: [2^i, 2^(i+1)) us
+
+      unsigned long long getTotalMicros() const;
+      unsigned long long getPercentile(double percent) const;
+   };
+
+   class QueryProfiler
+   {
+
+   public:
+      QueryProfiler();
+
+      void record(const std::string& sql, unsigned long long prepareMicros,
+         unsigned long long stepMicros, unsigned long long rows, sqlite3_stmt *statement);
+      std::vector<QueryProfile> getTop(size_t count);
+      std::string getReport(size_t count = TOP_COUNT);
+      void reset();
+
+      void setSlowThreshold(unsigned long long micros);
+      bool setSlowLog(std::string path);
+      unsigned long long getSlowCount();
+
+      static std::string normalize(std::string_view sql);
+
+      inline static const size_t TOP_COUNT = 20;
+      inline static const unsigned long long SLOW_THRESHOLD = 100000;
+
+   private:
+      std::mutex mylock;
+      std::unordered_map<std::string, QueryProfile> myprofiles;
+      unsigned long long myslowthreshold;
+      unsigned long long myslowcount;
+      std::ofstream myslowlog;
+
+      static int bucketOf(unsigned long long micros);
+   }; // class
+
+}; // namespace
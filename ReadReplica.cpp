@@ -0,0 +1,224 @@
+/*
+* Class ReadReplica
+* =================
+*
+* An in-memory copy of an on-disk Sqlite database, for read-heavy serving.
+*
+* The whole file is loaded into a ":memory:" database with SQLite's online
+* backup API, so reads never touch the disk or the page cache's misses.
+* getSnapshot() hands out the current copy.  refresh() builds a new copy
+* and swaps it in (double buffering): readers holding the old snapshot
+* finish on it undisturbed, and it is freed when the last one lets go.
+* refresh() first compares PRAGMA data_version on its read-only source
+* connection, so when nothing was committed since the last load it costs
+* one pragma.  startRefresh() does this on a timer from its own thread.
+*
+* The other direction is persist(): when writes go to the replica instead,
+* it copies the replica back to the file, pagesPerStep pages at a time with
+* an optional pause between steps, so readers of the file are only briefly
+* locked out.  Pick one direction per replica: a refresh discards writes
+* made to the snapshot, and a persist overwrites commits made to the file.
+*
+* A snapshot is an ordinary Sqlite connection: use it from one thread at a
+* time (ie, one replica per serving thread, or a lock around it).
+*
+-->
+gamzia::ReadReplica replica = gamzia::ReadReplica("accounts.db");
+replica.startRefresh(std::chrono::seconds(5));   // reload when changed
+
+std::shared_ptr<gamzia::Sqlite> db = replica.getSnapshot();
+gamzia::Cursor k = db->getCursor();
+k.execute("SELECT password FROM accounts WHERE user=?", params);
+row = k.fetchOne();
+<--
+*/
+
+#include "ReadReplica.h"
+#include "ConnectionPool.h"
+
+
+/// <summary>
+/// Constructor; opens dbname read-only and loads the first snapshot.
+/// </summary>
+/// <param name="dbname">An existing database file.</param>
+gamzia::ReadReplica::ReadReplica(std::string dbname)
+   : mysource(dbname)
+{
+   mydbname = dbname;
+   myversion = -1;
+   mystats = ReadReplicaStats();
+   isStopping = false;
+
+   if (!mysource.connect(SQLITE_OPEN_READONLY))
+   {
+      isReadyFlag = false;
+      myerror = mysource.getLastError();
+      return;
+   }
+
+   std::lock_guard<std::mutex> guard(myloadlock);
+   isReadyFlag = load();
+}
+
+gamzia::ReadReplica::~ReadReplica()
+{
+   stopRefresh();
+}
+
+bool gamzia::ReadReplica::isReady()
+{
+   return (isReadyFlag);
+}
+
+std::string gamzia::ReadReplica::getLastError()
+{
+   std::lock_guard<std::mutex> guard(mylock);
+   return (myerror);
+}
+
+/// <summary>
+/// Returns the current snapshot.  It stays valid for as long as it is held,
+/// even across refreshes.  Null if the first load failed.
+/// </summary>
+std::shared_ptr<gamzia::Sqlite> gamzia::ReadReplica::getSnapshot()
+{
+   std::lock_guard<std::mutex> guard(mylock);
+   return (mysnapshot);
+}
+
+/// <summary>
+/// Loads a new snapshot if the file changed since the last one.
+/// </summary>
+/// <param name="force">Reload even if nothing changed.</param>
+/// <returns>True if the snapshot is current.</returns>
+bool gamzia::ReadReplica::refresh(bool force)
+{
+   std::lock_guard<std::mutex> loading(myloadlock);
+
+   long long version = mysource.getDataVersion();
+   if (!force && version != -1 && version == myversion)
+   {
+      std::lock_guard<std::mutex> guard(mylock);
+      mystats.unchanged++;
+      return true;
+   }
+
+   if (!load())
+      return false;
+
+   std::lock_guard<std::mutex> guard(mylock);
+   mystats.refreshes++;
+   return true;
+}
+
+/// <summary>
+/// Calls refresh() every interval on a background thread, until
+/// stopRefresh() or destruction.  Restarts the thread if already running.
+/// </summary>
+/// <param name="interval">Time between checks.</param>
+void gamzia::ReadReplica::startRefresh(std::chrono::milliseconds interval)
+{
+   stopRefresh();
+   {
+      std::lock_guard<std::mutex> guard(mylock);
+      isStopping = false;
+   }
+   myrefresher = std::thread(&ReadReplica::run, this, interval);
+}
+
+void gamzia::ReadReplica::stopRefresh()
+{
+   {
+      std::lock_guard<std::mutex> guard(mylock);
+      isStopping = true;
+   }
+   mywake.notify_one();
+   if (myrefresher.joinable())
+      myrefresher.join();
+}
+
+/// <summary>
+/// Copies the current snapshot back to the file, replacing its contents.
+/// </summary>
+/// <param name="pagesPerStep">Pages copied per step (-1: all at once).</param>
+/// <param name="sleepMillis">Pause between steps, for other users of the file.</param>
+/// <returns>True once the file matches the snapshot.</returns>
+bool gamzia::ReadReplica::persist(int pagesPerStep, int sleepMillis)
+{
+   std::lock_guard<std::mutex> loading(myloadlock);
+   std::shared_ptr<Sqlite> snapshot = getSnapshot();
+   Sqlite target = Sqlite(mydbname);
+
+   if (snapshot == nullptr)
+      return false;
+
+   bool ok = target.connect() && target.setBusyTimeout(ConnectionPool::BUSY_TIMEOUT) &&
+      snapshot->backup(target, pagesPerStep, sleepMillis);
+
+   std::lock_guard<std::mutex> guard(mylock);
+   if (!ok)
+   {
+      myerror = target.getLastError();
+      mystats.failures++;
+      return false;
+   }
+
+   // The file now matches the snapshot; no need to load it back
+   myversion = mysource.getDataVersion();
+   mystats.persists++;
+   return true;
+}
+
+gamzia::ReadReplicaStats gamzia::ReadReplica::getStats()
+{
+   std::lock_guard<std::mutex> guard(mylock);
+   return (mystats);
+}
+
+/// <summary>
+/// Copies the file into a new ":memory:" database and swaps it in;
+/// myloadlock held.
+/// </summary>
+bool gamzia::ReadReplica::load()
+{
+   std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+   std::shared_ptr<Sqlite> replica = std::make_shared<Sqlite>(":memory:");
+
+   // Read before copying: a commit landing mid-copy bumps it again, so the
+   // next refresh picks that up
+   long long version = mysource.getDataVersion();
+
+   // One step: the copy is fast, and a stepped copy of a busy file restarts
+   bool ok = replica->connect() && mysource.backup(*replica, -1);
+
+   std::lock_guard<std::mutex> guard(mylock);
+   if (!ok)
+   {
+      myerror = replica->getLastError();
+      mystats.failures++;
+      return false;
+   }
+
+   mysnapshot = replica;
+   myversion = version;
+   mystats.generation++;
+   mystats.lastLoadMicros = (unsigned long long)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start).count();
+   return true;
+}
+
+/// <summary>
+/// Refresh thread.
+/// </summary>
+void gamzia::ReadReplica::run(std::chrono::milliseconds interval)
+{
+   for (;;)
+   {
+      {
+         std::unique_lock<std::mutex> guard(mylock);
+         if (mywake.wait_for(guard, interval, [this] { return isStopping; }))
+            return;
+      }
+      refresh();
+   }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include "Sqlite.h"
+
+namespace gamzia
+{
+
+   struct ReadReplicaStats
+   {
+      unsigned long long generation;      // snapshots loaded so far
+      unsigned long long refreshes;       // refresh() calls that reloaded
+      unsigned long long unchanged;       // refresh() calls skipped, nothing new
+      unsigned long long failures;
+      unsigned long long lastLoadMicros;
+      unsigned long long persists;
+   };
+
+   class ReadReplica
+   {
+
+   public:
+      ReadReplica(std::string dbname);
+      ~ReadReplica();
+      ReadReplica(const ReadReplica&) = delete;
+      ReadReplica& operator=(const ReadReplica&) = delete;
+
+      bool isReady();
+      std::string getLastError();
+      std::shared_ptr<Sqlite> getSnapshot();
+      bool refresh(bool force = false);
+      void startRefresh(std::chrono::milliseconds interval);
+      void stopRefresh();
+      bool persist(int pagesPerStep = Sqlite::BACKUP_STEP_PAGES, int sleepMillis = 0);
+      ReadReplicaStats getStats();
+
+   private:
+      std::string mydbname;
+      bool isReadyFlag;
+      std::string myerror;
+      Sqlite mysource;
+      long long myversion;
+      std::shared_ptr<Sqlite> mysnapshot;
+      ReadReplicaStats mystats;
+
+      std::mutex mylock;                  // mysnapshot, mystats, myerror
+      std::mutex myloadlock;              // one refresh or persist at a time
+      std::thread myrefresher;
+      std::condition_variable mywake;
+      bool isStopping;
+
+      bool load();
+      void run(std::chrono::milliseconds interval);
+   }; // class
+
+}; // namespace
@@ -0,0 +1,379 @@
+/*
+* Class ResultSet
+* ===============
+*
+* A column-major, in-memory copy of a query result, filled by
+* Cursor::fetchResultSet().
+*
+* Cursor::fetchAll() returns one std::string per cell with the column names
+* mixed in as the first row.  ResultSet instead keeps each column in a single
+* typed vector: integers as int64_t, reals as double, and text / blob data as
+* (offset, length) pairs into one contiguous arena shared by the whole set.
+* NULLs are tracked in a bitmap per column.  A million-row result is a handful
+* of large allocations instead of millions of small ones, and numeric columns
+* can be scanned directly as a span.
+*
+* A column's storage type follows SQLite's affinity order as values arrive:
+* an INTEGER column that meets a REAL becomes REAL, and a numeric column that
+* meets TEXT or BLOB is rewritten as text.  getString() returns the same text
+* fetchAll() would, except that integers in a widened column print as reals
+* ("2.0" rather than "2").
+*
+-->
+k.execute("SELECT id, name, salary FROM employees");
+gamzia::ResultSet rs = k.fetchResultSet();
+
+for (size_t r = 0; r < rs.getRowCount(); r++)
+   std::cout << rs.getInt64(r, 0) << " " << rs.getText(r, 1) << std::endl;
+
+double total = 0;
+for (double salary : rs.getDoubleColumn(2))
+   total += salary;
+<--
+*/
+
+#include "ResultSet.h"
+#include <charconv>
+#include <cstring>
+
+
+gamzia::ResultSet::ResultSet()
+{
+   myrows = 0;
+}
+
+/// <summary>
+/// Reads every remaining row of a prepared (or partly stepped) statement.
+/// Column names are taken from the statement, so they are available even
+/// when no rows come back.  Any previous content is discarded.
+/// </summary>
+/// <param name="statement">A prepared statement; stepped to completion.</param>
+void gamzia::ResultSet::load(sqlite3_stmt* statement)
+{
+   clear();
+   if (statement == nullptr)
+      return;
+
+   int columns = sqlite3_column_count(statement);
+   mycolumns.resize(columns);
+   for (int i = 0; i < columns; i++)
+   {
+      const char* name = sqlite3_column_name(statement, i);
+      mycolumns[i].name = (name == nullptr ? "" : name);
+      mycolumns[i].type = SQLITE_NULL;
+   }
+
+   while (sqlite3_step(statement) == SQLITE_ROW)
+   {
+      for (int i = 0; i < columns; i++)
+         append(mycolumns[i], statement, i);
+      myrows++;
+   }
+}
+
+void gamzia::ResultSet::clear()
+{
+   mycolumns.clear();
+   myarena.clear();
+   myrows = 0;
+}
+
+size_t gamzia::ResultSet::getRowCount() const
+{
+   return (myrows);
+}
+
+size_t gamzia::ResultSet::getColumnCount() const
+{
+   return (mycolumns.size());
+}
+
+std::string gamzia::ResultSet::getColumnName(size_t column) const
+{
+   return (mycolumns[column].name);
+}
+
+/// <summary>
+/// Returns the storage type of a whole column: SQLITE_INTEGER, SQLITE_FLOAT,
+/// SQLITE_TEXT, SQLITE_BLOB, or SQLITE_NULL if every value was NULL.
+/// </summary>
+int gamzia::ResultSet::getColumnType(size_t column) const
+{
+   return (mycolumns[column].type);
+}
+
+bool gamzia::ResultSet::isNull(size_t row, size_t column) const
+{
+   const Column& c = mycolumns[column];
+   return ((c.nulls[row / 64] >> (row % 64)) & 1);
+}
+
+/// <summary>
+/// Returns the value as an integer.  Reals are truncated and text is parsed;
+/// NULL and unparsable text give 0.
+/// </summary>
+int64_t gamzia::ResultSet::getInt64(size_t row, size_t column) const
+{
+   const Column& c = mycolumns[column];
+   switch (c.type)
+   {
+      case SQLITE_INTEGER:
+         return (c.ints[row]);
+      case SQLITE_FLOAT:
+         return ((int64_t)c.reals[row]);
+      case SQLITE_TEXT:
+      case SQLITE_BLOB:
+      {
+         std::string_view text = getText(row, column);
+         int64_t value = 0;
+         std::from_chars(text.data(), text.data() + text.size(), value);
+         return (value);
+      }
+   }
+   return (0);
+}
+
+/// <summary>
+/// Returns the value as a double.  Text is parsed; NULL and unparsable
+/// text give 0.0.
+/// </summary>
+double gamzia::ResultSet::getDouble(size_t row, size_t column) const
+{
+   const Column& c = mycolumns[column];
+   switch (c.type)
+   {
+      case SQLITE_INTEGER:
+         return ((double)c.ints[row]);
+      case SQLITE_FLOAT:
+         return (c.reals[row]);
+      case SQLITE_TEXT:
+      case SQLITE_BLOB:
+      {
+         std::string_view text = getText(row, column);
+         double value = 0.0;
+         std::from_chars(text.data(), text.data() + text.size(), value);
+         return (value);
+      }
+   }
+   return (0.0);
+}
+
+/// <summary>
+/// Returns a view into the arena for TEXT and BLOB columns, without copying.
+/// Numeric columns return an empty view; use getString() for those.
+/// Valid for the lifetime of the ResultSet.
+/// </summary>
+std::string_view gamzia::ResultSet::getText(size_t row, size_t column) const
+{
+   const Column& c = mycolumns[column];
+   if (c.type != SQLITE_TEXT && c.type != SQLITE_BLOB)
+      return std::string_view();
+   return std::string_view(myarena.data() + c.offsets[row], c.lengths[row]);
+}
+
+std::span<const std::byte> gamzia::ResultSet::getBlob(size_t row, size_t column) const
+{
+   std::string_view bytes = getText(row, column);
+   return std::span<const std::byte>((const std::byte*)bytes.data(), bytes.size());
+}
+
+/// <summary>
+/// Returns the value as a string, formatted the way SQLite (and so
+/// Cursor::fetchAll) would; integers widened to REAL print as reals.
+/// NULL comes back empty.
+/// </summary>
+std::string gamzia::ResultSet::getString(size_t row, size_t column) const
+{
+   if (isNull(row, column))
+      return ("");
+
+   const Column& c = mycolumns[column];
+   if (c.type == SQLITE_INTEGER)
+      return (std::to_string(c.ints[row]));
+   if (c.type == SQLITE_FLOAT)
+   {
+      char buffer[32];
+      sqlite3_snprintf(sizeof(buffer), buffer, "%!.15g", c.reals[row]);
+      return (std::string(buffer));
+   }
+   return (std::string(getText(row, column)));
+}
+
+/// <summary>
+/// Returns an INTEGER column as one contiguous span (NULLs read as 0; check
+/// isNull() where it matters).  Empty if the column is not INTEGER.
+/// </summary>
+std::span<const int64_t> gamzia::ResultSet::getInt64Column(size_t column) const
+{
+   const Column& c = mycolumns[column];
+   if (c.type != SQLITE_INTEGER)
+      return std::span<const int64_t>();
+   return std::span<const int64_t>(c.ints);
+}
+
+/// <summary>
+/// Returns a REAL column as one contiguous span (NULLs read as 0.0).  Empty
+/// if the column is not REAL.
+/// </summary>
+std::span<const double> gamzia::ResultSet::getDoubleColumn(size_t column) const
+{
+   const Column& c = mycolumns[column];
+   if (c.type != SQLITE_FLOAT)
+      return std::span<const double>();
+   return std::span<const double>(c.reals);
+}
+
+/// <summary>
+/// Approximate heap footprint in bytes (allocated capacity).
+/// </summary>
+size_t gamzia::ResultSet::getMemoryUsage() const
+{
+   size_t total = myarena.capacity() + mycolumns.capacity() * sizeof(Column);
+   for (const Column& c : mycolumns)
+   {
+      total += c.name.capacity();
+      total += c.ints.capacity() * sizeof(int64_t);
+      total += c.reals.capacity() * sizeof(double);
+      total += c.offsets.capacity() * sizeof(uint64_t);
+      total += c.lengths.capacity() * sizeof(uint32_t);
+      total += c.nulls.capacity() * sizeof(uint64_t);
+   }
+   return (total);
+}
+
+/// <summary>
+/// Appends the value of one column of the current row (row myrows).
+/// </summary>
+void gamzia::ResultSet::append(Column& column, sqlite3_stmt* statement, int index)
+{
+   size_t row = myrows;
+   if (row % 64 == 0)
+      column.nulls.push_back(0);
+
+   int type = sqlite3_column_type(statement, index);
+   if (type == SQLITE_NULL)
+   {
+      setNull(column, row);
+      return;
+   }
+
+   // First value decides the storage; earlier NULL rows get placeholders
+   if (column.type == SQLITE_NULL)
+   {
+      column.type = type;
+      if (type == SQLITE_INTEGER)
+         column.ints.resize(row, 0);
+      else if (type == SQLITE_FLOAT)
+         column.reals.resize(row, 0.0);
+      else
+      {
+         column.offsets.resize(row, 0);
+         column.lengths.resize(row, 0);
+      }
+   }
+   else if (type != column.type)
+   {
+      if (type == SQLITE_TEXT || type == SQLITE_BLOB)
+         promote(column, SQLITE_TEXT);
+      else if (type == SQLITE_FLOAT && column.type == SQLITE_INTEGER)
+         promote(column, SQLITE_FLOAT);
+   }
+
+   switch (column.type)
+   {
+      case SQLITE_INTEGER:
+         column.ints.push_back(sqlite3_column_int64(statement, index));
+         break;
+      case SQLITE_FLOAT:
+         column.reals.push_back(sqlite3_column_double(statement, index));
+         break;
+      case SQLITE_TEXT:
+      {
+         // Text first, then bytes: the byte count must describe the text form
+         const unsigned char* text = sqlite3_column_text(statement, index);
+         appendBytes(column, text, (size_t)sqlite3_column_bytes(statement, index));
+         break;
+      }
+      case SQLITE_BLOB:
+      {
+         const void* blob = sqlite3_column_blob(statement, index);
+         appendBytes(column, blob, (size_t)sqlite3_column_bytes(statement, index));
+         break;
+      }
+   }
+}
+
+void gamzia::ResultSet::setNull(Column& column, size_t row)
+{
+   column.nulls[row / 64] |= (uint64_t)1 << (row % 64);
+   switch (column.type)
+   {
+      case SQLITE_INTEGER:
+         column.ints.push_back(0);
+         break;
+      case SQLITE_FLOAT:
+         column.reals.push_back(0.0);
+         break;
+      case SQLITE_TEXT:
+      case SQLITE_BLOB:
+         appendBytes(column, nullptr, 0);
+         break;
+   }
+}
+
+void gamzia::ResultSet::appendBytes(Column& column, const void* data, size_t len)
+{
+   column.offsets.push_back(myarena.size());
+   column.lengths.push_back((uint32_t)len);
+   if (len > 0)
+      myarena.append((const char*)data, len);
+}
+
+/// <summary>
+/// Widens a column's storage: INTEGER to REAL, or any type to TEXT.
+/// Existing values are converted in place, formatted as SQLite would.
+/// </summary>
+void gamzia::ResultSet::promote(Column& column, int type)
+{
+   if (column.type == type)
+      return;
+
+   size_t rows = myrows;
+   if (type == SQLITE_FLOAT)
+   {
+      column.reals.reserve(rows + 1);
+      for (size_t r = 0; r < rows; r++)
+         column.reals.push_back((double)column.ints[r]);
+      std::vector<int64_t>().swap(column.ints);
+      column.type = SQLITE_FLOAT;
+      return;
+   }
+
+   // BLOB and TEXT already share the arena layout
+   if (column.type == SQLITE_BLOB)
+   {
+      column.type = SQLITE_TEXT;
+      return;
+   }
+
+   column.offsets.reserve(rows + 1);
+   column.lengths.reserve(rows + 1);
+   for (size_t r = 0; r < rows; r++)
+   {
+      if ((column.nulls[r / 64] >> (r % 64)) & 1)
+      {
+         appendBytes(column, nullptr, 0);
+         continue;
+      }
+
+      char buffer[32];
+      if (column.type == SQLITE_INTEGER)
+         sqlite3_snprintf(sizeof(buffer), buffer, "%lld", (long long)column.ints[r]);
+      else
+         sqlite3_snprintf(sizeof(buffer), buffer, "%!.15g", column.reals[r]);
+      appendBytes(column, buffer, strlen(buffer));
+   }
+   std::vector<int64_t>().swap(column.ints);
+   std::vector<double>().swap(column.reals);
+   column.type = SQLITE_TEXT;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <span>
+#include <vector>
+#include <cstdint>
+#include "sqlite3.h"
+
+namespace gamzia
+{
+
+   class ResultSet
+   {
+
+   public:
+      ResultSet();
+      void load(sqlite3_stmt *statement);
+      void clear();
+
+      size_t getRowCount() const;
+      size_t getColumnCount() const;
+      std::string getColumnName(size_t column) const;
+      int getColumnType(size_t column) const;
+
+      bool isNull(size_t row, size_t column) const;
+      int64_t getInt64(size_t row, size_t column) const;
+      double getDouble(size_t row, size_t column) const;
+      std::string_view getText(size_t row, size_t column) const;
+      std::span<const std::byte> getBlob(size_t row, size_t column) const;
+      std::string getString(size_t row, size_t column) const;
+
+      std::span<const int64_t> getInt64Column(size_t column) const;
+      std::span<const double> getDoubleColumn(size_t column) const;
+      size_t getMemoryUsage() const;
+
+   private:
+      struct Column
+      {
+         std::string name;
+         int type;                        // SQLITE_NULL until the first value
+         std::vector<int64_t> ints;       // SQLITE_INTEGER
+         std::vector<double> reals;       // SQLITE_FLOAT
+         std::vector<uint64_t> offsets;   // SQLITE_TEXT / SQLITE_BLOB: into myarena
+         std::vector<uint32_t> lengths;
+         std::vector<uint64_t> nulls;     // one bit per row
+      };
+
+      std::vector<Column> mycolumns;
+      std::string myarena;
+      size_t myrows;
+
+      void append(Column& column, sqlite3_stmt *statement, int index);
+      void setNull(Column& column, size_t row);
+      void appendBytes(Column& column, const void *data, size_t len);
+      void promote(Column& column, int type);
+   }; // class
+
+}; // namespace
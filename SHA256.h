@@ -1,53 +1,89 @@
-#ifndef SHA256_H
-#define SHA256_H
-#include <string>
-
-class SHA256
-{
-protected:
-    typedef unsigned char uint8;
-    typedef unsigned int uint32;
-    typedef unsigned long long uint64;
-
-    const static uint32 sha256_k[];
-    static const unsigned int SHA224_256_BLOCK_SIZE = (512/8);
-
-    void transform(const unsigned char* message, unsigned int block_nb);
-    unsigned int m_tot_len;
-    unsigned int m_len;
-    unsigned char m_block[2 * SHA224_256_BLOCK_SIZE];
-    uint32 m_h[8];
-
-public:
-    void init();
-    void update(const unsigned char *message, unsigned int len);
-    void final(unsigned char *digest);
-    static const unsigned int DIGEST_SIZE = ( 256 / 8);
-};
-
-std::string sha256(std::string input);
-
-#define SHA2_SHFR(x, n)    (x >> n)
-#define SHA2_ROTR(x, n)   ((x >> n) | (x << ((sizeof(x) << 3) - n)))
-#define SHA2_ROTL(x, n)   ((x << n) | (x >> ((sizeof(x) << 3) - n)))
-#define SHA2_CH(x, y, z)  ((x & y) ^ (~x & z))
-#define SHA2_MAJ(x, y, z) ((x & y) ^ (x & z) ^ (y & z))
-#define SHA256_F1(x) (SHA2_ROTR(x,  2) ^ SHA2_ROTR(x, 13) ^ SHA2_ROTR(x, 22))
-#define SHA256_F2(x) (SHA2_ROTR(x,  6) ^ SHA2_ROTR(x, 11) ^ SHA2_ROTR(x, 25))
-#define SHA256_F3(x) (SHA2_ROTR(x,  7) ^ SHA2_ROTR(x, 18) ^ SHA2_SHFR(x,  3))
-#define SHA256_F4(x) (SHA2_ROTR(x, 17) ^ SHA2_ROTR(x, 19) ^ SHA2_SHFR(x, 10))
-#define SHA2_UNPACK32(x, str)                 \
-{                                             \
-    *((str) + 3) = (uint8) ((x)      );       \
-    *((str) + 2) = (uint8) ((x) >>  8);       \
-    *((str) + 1) = (uint8) ((x) >> 16);       \
-    *((str) + 0) = (uint8) ((x) >> 24);       \
-}
-#define SHA2_PACK32(str, x)                   \
-{                                             \
-    *(x) =   ((uint32) *((str) + 3)      )    \
-           | ((uint32) *((str) + 2) <<  8)    \
-           | ((uint32) *((str) + 1) << 16)    \
-           | ((uint32) *((str) + 0) << 24);   \
-}
-#endif
+#ifndef SHA256_H
+#define SHA256_H
+#include <string>
+#include <string_view>
+#include <span>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "SHA2Core.h"
+
+#define SHA256_F1(x) (SHA2_ROTR(x,  2) ^ SHA2_ROTR(x, 13) ^ SHA2_ROTR(x, 22))
+#define SHA256_F2(x) (SHA2_ROTR(x,  6) ^ SHA2_ROTR(x, 11) ^ SHA2_ROTR(x, 25))
+#define SHA256_F3(x) (SHA2_ROTR(x,  7) ^ SHA2_ROTR(x, 18) ^ SHA2_SHFR(x,  3))
+#define SHA256_F4(x) (SHA2_ROTR(x, 17) ^ SHA2_ROTR(x, 19) ^ SHA2_SHFR(x, 10))
+
+struct SHA256Traits
+{
+    typedef unsigned int word;
+    static const unsigned int ROUNDS = 64;
+    static const unsigned int BLOCK_SIZE = (512/8);
+    static const unsigned int DIGEST_SIZE = (256/8);
+    static const unsigned char STATE_ID = 1;
+
+    static constexpr word K[64] = //UL = uint32
+            {0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+             0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+             0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+             0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+             0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+             0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+             0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+             0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+             0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+             0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+             0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+             0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+             0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+             0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+             0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+             0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+    static constexpr word H0[8] =
+            {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+             0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+    static constexpr word f1(word x) { return SHA256_F1(x); }
+    static constexpr word f2(word x) { return SHA256_F2(x); }
+    static constexpr word f3(word x) { return SHA256_F3(x); }
+    static constexpr word f4(word x) { return SHA256_F4(x); }
+};
+
+class SHA256 : public SHA2Core<SHA256Traits>
+{
+};
+
+typedef std::array<uint8_t, SHA256::DIGEST_SIZE> SHA256Digest;
+
+/*
+ * Allocation free interface.  sha256Digest() returns the raw digest by
+ * value, and sha256ToHex() writes exactly 2*DIGEST_SIZE lowercase hex
+ * characters (no terminator) into a caller supplied buffer, returning the
+ * position just past them.  Both are constexpr, so fixed salts and keys can
+ * be hashed at compile time:
+ *
+ *    constexpr SHA256Digest SALT = sha256Digest("gamzia");
+ */
+constexpr SHA256Digest sha256Digest(std::string_view input)
+{
+    return sha2Digest<SHA256>(input);
+}
+
+inline SHA256Digest sha256Digest(std::span<const std::byte> input)
+{
+    SHA256Digest digest{};
+    SHA256 ctx = SHA256();
+    ctx.init();
+    ctx.update(input);
+    ctx.final(digest.data());
+    return digest;
+}
+
+constexpr char* sha256ToHex(const SHA256Digest& digest, char *out)
+{
+    return sha2ToHex(digest, out);
+}
+
+std::string sha256(std::string_view input);
+std::string sha256File(const std::string& path, bool sequentialHint = true);
+#endif
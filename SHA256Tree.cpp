@@ -0,0 +1,400 @@
+/*
+* Class SHA256Tree
+* ================
+*
+* An opt-in tree hash (Merkle) mode built on the SHA256 class, for very large
+* inputs where a single SHA-256 stream would be limited to one core.
+*
+* The input is split into fixed size chunks.  Each chunk is a leaf, hashed
+* independently (and in parallel, across a small pool of worker threads).
+* Leaves are then combined pairwise, level by level, into a single root:
+*
+*    leaf = SHA256(0x00 || chunk)
+*    node = SHA256(0x01 || left || right)
+*
+* The prefix bytes keep leaves and nodes in separate domains, so a node can
+* never be passed off as a leaf.  When a level has an odd number of entries,
+* the last one is promoted to the next level unchanged.
+*
+* Because the root commits to every leaf, a single chunk can be verified
+* against a known root with only its "proof" (the sibling digests on its path
+* to the root) - there is no need to rehash the entire file.
+*
+* NOTE: The root is NOT the same value as sha256() of the whole input.  Plain
+* sha256() remains the compatible default; use this class only when both sides
+* agree on tree hashing and on the chunk size.
+*
+-->
+gamzia::SHA256Tree tree = gamzia::SHA256Tree(4 << 20);
+tree.hashFile("artifact.bin");
+std::string root = tree.getRoot();
+
+// Later, verify chunk 7 on its own
+std::vector<gamzia::SHA256Tree::Digest> proof = tree.getProof(7);
+bool ok = gamzia::SHA256Tree::verifyChunk(chunk, chunkLen, 7, tree.getChunkCount(),
+                                          proof, tree.getRootDigest());
+<--
+*/
+
+#include "SHA256Tree.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <fstream>
+#include "SHA256.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+static const unsigned char LEAF_PREFIX = 0x00;
+static const unsigned char NODE_PREFIX = 0x01;
+
+
+/// <summary>
+/// Default constructor.  Uses DEFAULT_CHUNK_SIZE and one worker per core.
+/// </summary>
+gamzia::SHA256Tree::SHA256Tree()
+{
+   mychunksize = DEFAULT_CHUNK_SIZE;
+   mythreads = 0;
+}
+
+
+/// <summary>
+/// Constructor.
+/// </summary>
+/// <param name="chunkSize">Leaf size in bytes.  Both sides of a verification must agree on it.</param>
+/// <param name="threads">Number of worker threads; 0 uses the hardware concurrency.</param>
+gamzia::SHA256Tree::SHA256Tree(size_t chunkSize, unsigned int threads)
+{
+   mychunksize = (chunkSize == 0) ? DEFAULT_CHUNK_SIZE : chunkSize;
+   mythreads = threads;
+}
+
+
+/// <summary>
+/// Hashes a single leaf (chunk).
+/// </summary>
+gamzia::SHA256Tree::Digest gamzia::SHA256Tree::hashLeaf(const unsigned char* chunk, size_t len)
+{
+   Digest digest;
+   SHA256 ctx = SHA256();
+
+   ctx.init();
+   ctx.update(&LEAF_PREFIX, 1);
+   ctx.update(chunk, len);
+   ctx.final(digest.data());
+   return (digest);
+}
+
+
+/// <summary>
+/// Hashes an interior node from its two children.
+/// </summary>
+gamzia::SHA256Tree::Digest gamzia::SHA256Tree::hashNode(const Digest& left, const Digest& right)
+{
+   Digest digest;
+   SHA256 ctx = SHA256();
+
+   ctx.init();
+   ctx.update(&NODE_PREFIX, 1);
+   ctx.update(left.data(), left.size());
+   ctx.update(right.data(), right.size());
+   ctx.final(digest.data());
+   return (digest);
+}
+
+
+/// <summary>
+/// Hashes all leaves across the worker pool.  Each worker obtains its own
+/// chunk hasher from makeHasher (so it can own a file handle and buffer), then
+/// pulls chunk indexes off a shared counter until none are left.
+/// </summary>
+/// <returns>True if every chunk hashed successfully.</returns>
+bool gamzia::SHA256Tree::hashLeaves(size_t chunkCount, std::function<ChunkHasher()> makeHasher)
+{
+   std::atomic<size_t> next(0);
+   std::atomic<bool> failed(false);
+   unsigned int workers;
+
+   mylevels.clear();
+   mylevels.push_back(std::vector<Digest>(chunkCount));
+
+   workers = mythreads;
+   if (workers == 0)
+      workers = std::thread::hardware_concurrency();
+   if (workers == 0)
+      workers = 1;
+   if (workers > chunkCount)
+      workers = (unsigned int)chunkCount;
+
+   auto work = [&]()
+   {
+      ChunkHasher hashChunk = makeHasher();
+      size_t index;
+      while (!failed && (index = next.fetch_add(1)) < chunkCount)
+      {
+         if (!hashChunk(index, mylevels[0][index]))
+            failed = true;
+      }
+   };
+
+   // The calling thread is one of the workers
+   std::vector<std::thread> pool;
+   for (unsigned int i = 1; i < workers; i++)
+      pool.push_back(std::thread(work));
+   work();
+   for (std::thread& t : pool)
+      t.join();
+
+   if (failed)
+   {
+      mylevels.clear();
+      return false;
+   }
+
+   buildLevels();
+   return true;
+}
+
+
+/// <summary>
+/// Combines the leaf level pairwise up to the root.  An odd entry at the
+/// end of a level is promoted unchanged.
+/// </summary>
+void gamzia::SHA256Tree::buildLevels()
+{
+   while (mylevels.back().size() > 1)
+   {
+      const std::vector<Digest>& below = mylevels.back();
+      std::vector<Digest> level;
+
+      level.reserve((below.size() + 1) / 2);
+      for (size_t i = 0; i + 1 < below.size(); i += 2)
+         level.push_back(hashNode(below[i], below[i + 1]));
+      if (below.size() % 2 == 1)
+         level.push_back(below.back());
+
+      mylevels.push_back(std::move(level));
+   }
+}
+
+
+/// <summary>
+/// Tree hashes an in-memory buffer.  An empty buffer is a single empty leaf.
+/// </summary>
+/// <returns>True on success.</returns>
+bool gamzia::SHA256Tree::hash(const unsigned char* data, size_t len)
+{
+   size_t chunkCount = (len == 0) ? 1 : (len + mychunksize - 1) / mychunksize;
+   size_t chunkSize = mychunksize;
+
+   return hashLeaves(chunkCount, [data, len, chunkSize]()
+   {
+      return ChunkHasher([data, len, chunkSize](size_t index, Digest& digest)
+      {
+         size_t offset = index * chunkSize;
+         size_t size = (len - offset < chunkSize) ? len - offset : chunkSize;
+         digest = hashLeaf(data + offset, size);
+         return true;
+      });
+   });
+}
+
+
+/// <summary>
+/// Tree hashes a string.
+/// </summary>
+bool gamzia::SHA256Tree::hash(const std::string& data)
+{
+   return hash((const unsigned char*)data.data(), data.size());
+}
+
+
+/// <summary>
+/// Tree hashes a file.  Each worker opens its own handle and reads only
+/// the chunks it hashes, so reads are spread across the pool as well.
+/// </summary>
+/// <param name="path">The file to hash.</param>
+/// <returns>True on success; false if the file could not be opened or read.</returns>
+bool gamzia::SHA256Tree::hashFile(std::string path)
+{
+   unsigned long long fileSize;
+   size_t chunkCount;
+   size_t chunkSize = mychunksize;
+
+   mylevels.clear();
+
+#ifdef _WIN32
+   std::ifstream probe(path, std::ios::in | std::ios::binary | std::ios::ate);
+   if (!probe)
+      return false;
+   fileSize = (unsigned long long)probe.tellg();
+   probe.close();
+#else
+   struct stat info;
+   if (stat(path.c_str(), &info) != 0)
+      return false;
+   fileSize = (unsigned long long)info.st_size;
+#endif
+
+   chunkCount = (fileSize == 0) ? 1 : (size_t)((fileSize + chunkSize - 1) / chunkSize);
+
+   return hashLeaves(chunkCount, [path, fileSize, chunkSize]()
+   {
+      auto buffer = std::make_shared<std::vector<unsigned char>>(chunkSize);
+
+#ifdef _WIN32
+      auto in = std::make_shared<std::ifstream>(path, std::ios::in | std::ios::binary);
+      return ChunkHasher([in, buffer, fileSize, chunkSize](size_t index, Digest& digest)
+      {
+         unsigned long long offset = (unsigned long long)index * chunkSize;
+         size_t size = (size_t)((fileSize - offset < chunkSize) ? fileSize - offset : chunkSize);
+
+         if (!*in)
+            return false;
+         in->seekg((std::streamoff)offset);
+         in->read((char*)buffer->data(), (std::streamsize)size);
+         if ((size_t)in->gcount() != size)
+            return false;
+         digest = hashLeaf(buffer->data(), size);
+         return true;
+      });
+#else
+      int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      auto handle = std::shared_ptr<int>(new int(fd), [](int* p) { if (*p >= 0) close(*p); delete p; });
+      return ChunkHasher([handle, buffer, fileSize, chunkSize](size_t index, Digest& digest)
+      {
+         unsigned long long offset = (unsigned long long)index * chunkSize;
+         size_t size = (size_t)((fileSize - offset < chunkSize) ? fileSize - offset : chunkSize);
+         size_t done = 0;
+
+         if (*handle < 0)
+            return false;
+         while (done < size)
+         {
+            ssize_t got = pread(*handle, buffer->data() + done, size - done, (off_t)(offset + done));
+            if (got < 0 && errno == EINTR)
+               continue;
+            if (got <= 0)
+               return false;
+            done += (size_t)got;
+         }
+         digest = hashLeaf(buffer->data(), size);
+         return true;
+      });
+#endif
+   });
+}
+
+
+/// <summary>
+/// Returns the root as a lowercase hex string, or empty if nothing was hashed.
+/// </summary>
+std::string gamzia::SHA256Tree::getRoot()
+{
+   std::string hex(2 * SHA256::DIGEST_SIZE, '0');
+
+   if (mylevels.empty())
+      return "";
+
+   sha256ToHex(mylevels.back()[0], hex.data());
+   return (hex);
+}
+
+
+/// <summary>
+/// Returns the raw root digest (all zero if nothing was hashed).
+/// </summary>
+gamzia::SHA256Tree::Digest gamzia::SHA256Tree::getRootDigest()
+{
+   if (mylevels.empty())
+      return Digest{};
+   return (mylevels.back()[0]);
+}
+
+
+size_t gamzia::SHA256Tree::getChunkSize()
+{
+   return (mychunksize);
+}
+
+
+size_t gamzia::SHA256Tree::getChunkCount()
+{
+   if (mylevels.empty())
+      return 0;
+   return (mylevels[0].size());
+}
+
+
+/// <summary>
+/// Builds the inclusion proof for one chunk: the sibling digest at each
+/// level, bottom up.  Levels where the node was promoted contribute nothing.
+/// </summary>
+/// <param name="index">Zero based chunk index.</param>
+/// <returns>The proof; empty if index is out of range (or the tree is a single leaf).</returns>
+std::vector<gamzia::SHA256Tree::Digest> gamzia::SHA256Tree::getProof(size_t index)
+{
+   std::vector<Digest> proof;
+
+   if (mylevels.empty() || index >= mylevels[0].size())
+      return (proof);
+
+   for (size_t level = 0; level + 1 < mylevels.size(); level++)
+   {
+      const std::vector<Digest>& nodes = mylevels[level];
+      if (index % 2 == 1)
+         proof.push_back(nodes[index - 1]);
+      else if (index + 1 < nodes.size())
+         proof.push_back(nodes[index + 1]);
+      index /= 2;
+   }
+   return (proof);
+}
+
+
+/// <summary>
+/// Verifies a single chunk against a root, using its proof from getProof().
+/// </summary>
+/// <param name="chunk">The chunk data.</param>
+/// <param name="len">The chunk length.</param>
+/// <param name="index">Zero based chunk index.</param>
+/// <param name="chunkCount">Total number of chunks in the tree.</param>
+/// <param name="proof">Sibling digests from getProof().</param>
+/// <param name="root">The trusted root digest.</param>
+/// <returns>True if the chunk belongs at index under root.</returns>
+bool gamzia::SHA256Tree::verifyChunk(const unsigned char* chunk, size_t len, size_t index, size_t chunkCount,
+   const std::vector<Digest>& proof, const Digest& root)
+{
+   Digest digest;
+   size_t used = 0;
+
+   if (index >= chunkCount)
+      return false;
+
+   digest = hashLeaf(chunk, len);
+   while (chunkCount > 1)
+   {
+      if (index % 2 == 1)
+      {
+         if (used >= proof.size())
+            return false;
+         digest = hashNode(proof[used++], digest);
+      }
+      else if (index + 1 < chunkCount)
+      {
+         if (used >= proof.size())
+            return false;
+         digest = hashNode(digest, proof[used++]);
+      }
+      index /= 2;
+      chunkCount = (chunkCount + 1) / 2;
+   }
+
+   return (used == proof.size() && digest == root);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <array>
+#include <functional>
+#include "SHA256.h"
+
+namespace gamzia
+{
+
+   class SHA256Tree
+   {
+   public:
+      typedef SHA256Digest Digest;
+
+      SHA256Tree();
+      SHA256Tree(size_t chunkSize, unsigned int threads = 0);
+
+      bool hash(const unsigned char* data, size_t len);
+      bool hash(const std::string& data);
+      bool hashFile(std::string path);
+
+      std::string getRoot();
+      Digest getRootDigest();
+      size_t getChunkSize();
+      size_t getChunkCount();
+      std::vector<Digest> getProof(size_t index);
+
+      static bool verifyChunk(const unsigned char* chunk, size_t len, size_t index, size_t chunkCount,
+         const std::vector<Digest>& proof, const Digest& root);
+      static Digest hashLeaf(const unsigned char* chunk, size_t len);
+      static Digest hashNode(const Digest& left, const Digest& right);
+
+      inline static const size_t DEFAULT_CHUNK_SIZE = 1 << 20;
+
+   private:
+      typedef std::function<bool(size_t, Digest&)> ChunkHasher;
+
+      size_t mychunksize;
+      unsigned int mythreads;
+      std::vector<std::vector<Digest>> mylevels;
+
+      bool hashLeaves(size_t chunkCount, std::function<ChunkHasher()> makeHasher);
+      void buildLevels();
+   }; // class
+
+}; // namespace
@@ -0,0 +1,330 @@
+#ifndef SHA2CORE_H
+#define SHA2CORE_H
+/*
+ * Templated SHA-2 core shared by SHA256 (32-bit words, 64 byte blocks) and
+ * the SHA512 family (64-bit words, 128 byte blocks).  A Traits struct supplies
+ * the word type, round constants, initial hash value and sigma functions.
+ *
+ * The core lives in a header so it can be evaluated at compile time
+ * (constexpr).  Based on Olivier Gay's FIPS 180-2 implementation, as updated
+ * to C++ by zedwood.com; see SHA256.cpp for the Modified BSD License.
+ */
+#include <string>
+#include <string_view>
+#include <vector>
+#include <span>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#define SHA2_SHFR(x, n)    (x >> n)
+#define SHA2_ROTR(x, n)   ((x >> n) | (x << ((sizeof(x) << 3) - n)))
+#define SHA2_ROTL(x, n)   ((x << n) | (x >> ((sizeof(x) << 3) - n)))
+#define SHA2_CH(x, y, z)  ((x & y) ^ (~x & z))
+#define SHA2_MAJ(x, y, z) ((x & y) ^ (x & z) ^ (y & z))
+#define SHA2_UNPACK32(x, str)                 \
+{                                             \
+    *((str) + 3) = (uint8) ((x)      );       \
+    *((str) + 2) = (uint8) ((x) >>  8);       \
+    *((str) + 1) = (uint8) ((x) >> 16);       \
+    *((str) + 0) = (uint8) ((x) >> 24);       \
+}
+#define SHA2_UNPACK64(x, str)                 \
+{                                             \
+    *((str) + 7) = (uint8) ((x)      );       \
+    *((str) + 6) = (uint8) ((x) >>  8);       \
+    *((str) + 5) = (uint8) ((x) >> 16);       \
+    *((str) + 4) = (uint8) ((x) >> 24);       \
+    *((str) + 3) = (uint8) ((x) >> 32);       \
+    *((str) + 2) = (uint8) ((x) >> 40);       \
+    *((str) + 1) = (uint8) ((x) >> 48);       \
+    *((str) + 0) = (uint8) ((x) >> 56);       \
+}
+#define SHA2_PACK32(str, x)                   \
+{                                             \
+    *(x) =   ((uint32) (uint8) *((str) + 3)      )    \
+           | ((uint32) (uint8) *((str) + 2) <<  8)    \
+           | ((uint32) (uint8) *((str) + 1) << 16)    \
+           | ((uint32) (uint8) *((str) + 0) << 24);   \
+}
+#define SHA2_PACK64(str, x)                   \
+{                                             \
+    *(x) =   ((uint64) (uint8) *((str) + 7)      )    \
+           | ((uint64) (uint8) *((str) + 6) <<  8)    \
+           | ((uint64) (uint8) *((str) + 5) << 16)    \
+           | ((uint64) (uint8) *((str) + 4) << 24)    \
+           | ((uint64) (uint8) *((str) + 3) << 32)    \
+           | ((uint64) (uint8) *((str) + 2) << 40)    \
+           | ((uint64) (uint8) *((str) + 1) << 48)    \
+           | ((uint64) (uint8) *((str) + 0) << 56);   \
+}
+
+template <typename Traits>
+class SHA2Core
+{
+protected:
+    typedef unsigned char uint8;
+    typedef unsigned int uint32;
+    typedef unsigned long long uint64;
+    typedef typename Traits::word word;
+
+    static const unsigned int WORD_SIZE = sizeof(word);
+    static const unsigned int LENGTH_SIZE = 2 * sizeof(word);
+
+    // Byte may be char, unsigned char or std::byte; each is read through
+    // uint8, so no reinterpret_cast is needed and the core stays constexpr.
+    template <typename Byte>
+    constexpr void transform(const Byte* message, size_t block_nb)
+    {
+        word w[Traits::ROUNDS];
+        word wv[8];
+        word t1, t2;
+        const Byte *sub_block;
+        size_t i;
+        unsigned int j;
+        for (i = 0; i < block_nb; i++) {
+            sub_block = message + i * Traits::BLOCK_SIZE;
+            for (j = 0; j < 16; j++) {
+                if constexpr (WORD_SIZE == 4)
+                    SHA2_PACK32(&sub_block[j * WORD_SIZE], &w[j])
+                else
+                    SHA2_PACK64(&sub_block[j * WORD_SIZE], &w[j])
+            }
+            for (j = 16; j < Traits::ROUNDS; j++) {
+                w[j] =  Traits::f4(w[j -  2]) + w[j -  7] + Traits::f3(w[j - 15]) + w[j - 16];
+            }
+            for (j = 0; j < 8; j++) {
+                wv[j] = m_h[j];
+            }
+            for (j = 0; j < Traits::ROUNDS; j++) {
+                t1 = wv[7] + Traits::f2(wv[4]) + SHA2_CH(wv[4], wv[5], wv[6])
+                    + Traits::K[j] + w[j];
+                t2 = Traits::f1(wv[0]) + SHA2_MAJ(wv[0], wv[1], wv[2]);
+                wv[7] = wv[6];
+                wv[6] = wv[5];
+                wv[5] = wv[4];
+                wv[4] = wv[3] + t1;
+                wv[3] = wv[2];
+                wv[2] = wv[1];
+                wv[1] = wv[0];
+                wv[0] = t1 + t2;
+            }
+            for (j = 0; j < 8; j++) {
+                m_h[j] += wv[j];
+            }
+        }
+    }
+
+    template <typename Byte>
+    constexpr void absorb(const Byte *message, size_t len)
+    {
+        size_t block_nb;
+        size_t new_len, rem_len, tmp_len, k;
+        const Byte *shifted_message;
+        tmp_len = Traits::BLOCK_SIZE - m_len;
+        rem_len = len < tmp_len ? len : tmp_len;
+        for (k = 0; k < rem_len; k++)
+            m_block[m_len + k] = (uint8) message[k];
+        if (m_len + len < Traits::BLOCK_SIZE) {
+            m_len += (unsigned int) len;
+            return;
+        }
+        new_len = len - rem_len;
+        block_nb = new_len / Traits::BLOCK_SIZE;
+        shifted_message = message + rem_len;
+        transform(m_block, 1);
+        transform(shifted_message, block_nb);
+        rem_len = new_len % Traits::BLOCK_SIZE;
+        for (k = 0; k < rem_len; k++)
+            m_block[k] = (uint8) shifted_message[block_nb * Traits::BLOCK_SIZE + k];
+        m_len = (unsigned int) rem_len;
+        m_tot_len += (uint64) (block_nb + 1) * Traits::BLOCK_SIZE;
+    }
+
+    uint64 m_tot_len = 0;
+    unsigned int m_len = 0;
+    unsigned char m_block[2 * Traits::BLOCK_SIZE] = {};
+    word m_h[8] = {};
+
+public:
+    /*
+     * A snapshot of the running hash (chaining value, lengths and buffered
+     * partial block).  Saving a state after a common prefix and restoring it
+     * for each message skips recompressing that prefix; HMAC uses this to
+     * cache its keyed inner and outer pads.
+     */
+    struct State
+    {
+        word h[8];
+        uint64 tot_len;
+        unsigned int len;
+        unsigned char block[Traits::BLOCK_SIZE];
+    };
+
+    constexpr State saveState() const
+    {
+        State state{};
+        for (int i = 0; i < 8; i++)
+            state.h[i] = m_h[i];
+        state.tot_len = m_tot_len;
+        state.len = m_len;
+        for (unsigned int k = 0; k < m_len; k++)
+            state.block[k] = m_block[k];
+        return state;
+    }
+
+    constexpr void restoreState(const State& state)
+    {
+        for (int i = 0; i < 8; i++)
+            m_h[i] = state.h[i];
+        m_tot_len = state.tot_len;
+        m_len = state.len < Traits::BLOCK_SIZE ? state.len : 0;
+        for (unsigned int k = 0; k < m_len; k++)
+            m_block[k] = state.block[k];
+    }
+
+    /*
+     * Serialized state, for hashes that must survive a process restart.
+     * Layout (all integers big endian):
+     *
+     *    version (1) | algorithm id (1) | total length (8) | buffered length (1)
+     *    | chaining value (8 words) | buffered bytes
+     *
+     * importState() rejects blobs of another version or algorithm, and any
+     * blob whose lengths are inconsistent, leaving the hash untouched.
+     */
+    static const unsigned char STATE_VERSION = 1;
+
+    std::vector<unsigned char> exportState() const
+    {
+        std::vector<unsigned char> blob(11 + 8 * WORD_SIZE + m_len);
+        unsigned char *p = blob.data();
+        *p++ = STATE_VERSION;
+        *p++ = Traits::STATE_ID;
+        SHA2_UNPACK64(m_tot_len, p);
+        p += 8;
+        *p++ = (uint8) m_len;
+        for (int i = 0; i < 8; i++) {
+            for (unsigned int b = 0; b < WORD_SIZE; b++)
+                *p++ = (uint8) (m_h[i] >> (8 * (WORD_SIZE - 1 - b)));
+        }
+        for (unsigned int k = 0; k < m_len; k++)
+            *p++ = m_block[k];
+        return blob;
+    }
+
+    bool importState(const unsigned char *blob, size_t len)
+    {
+        State state{};
+        const unsigned char *p = blob;
+
+        if (blob == nullptr || len < 11 + 8 * WORD_SIZE)
+            return false;
+        if (p[0] != STATE_VERSION || p[1] != Traits::STATE_ID)
+            return false;
+        p += 2;
+        for (int b = 0; b < 8; b++)
+            state.tot_len = (state.tot_len << 8) | *p++;
+        state.len = *p++;
+        if (state.len >= Traits::BLOCK_SIZE || state.tot_len % Traits::BLOCK_SIZE != 0
+            || len != 11 + 8 * WORD_SIZE + state.len)
+            return false;
+        for (int i = 0; i < 8; i++) {
+            state.h[i] = 0;
+            for (unsigned int b = 0; b < WORD_SIZE; b++)
+                state.h[i] = (state.h[i] << 8) | *p++;
+        }
+        for (unsigned int k = 0; k < state.len; k++)
+            state.block[k] = *p++;
+
+        restoreState(state);
+        return true;
+    }
+
+    bool importState(const std::vector<unsigned char>& blob)
+    {
+        return importState(blob.data(), blob.size());
+    }
+
+    constexpr void init()
+    {
+        for (int i = 0; i < 8; i++)
+            m_h[i] = Traits::H0[i];
+        m_len = 0;
+        m_tot_len = 0;
+    }
+
+    constexpr void update(const unsigned char *message, size_t len)
+    {
+        absorb(message, len);
+    }
+
+    constexpr void update(std::string_view message)
+    {
+        absorb(message.data(), message.size());
+    }
+
+    constexpr void update(std::span<const std::byte> message)
+    {
+        absorb(message.data(), message.size());
+    }
+
+    // Writes DIGEST_SIZE bytes; truncated variants (SHA-512/256) simply
+    // emit the leading bytes of the chaining value.
+    constexpr void final(unsigned char *digest)
+    {
+        unsigned int block_nb;
+        unsigned int pm_len;
+        uint64 len_b;
+        unsigned int k;
+        block_nb = (1 + ((Traits::BLOCK_SIZE - (LENGTH_SIZE + 1))
+                         < (m_len % Traits::BLOCK_SIZE)));
+        len_b = (m_tot_len + m_len) << 3;
+        pm_len = block_nb * Traits::BLOCK_SIZE;
+        for (k = m_len; k < pm_len; k++)
+            m_block[k] = 0;
+        m_block[m_len] = 0x80;
+        SHA2_UNPACK64(len_b, m_block + pm_len - 8);
+        transform(m_block, block_nb);
+        for (k = 0; k < Traits::DIGEST_SIZE; k++)
+            digest[k] = (uint8) (m_h[k / WORD_SIZE] >> (8 * (WORD_SIZE - 1 - k % WORD_SIZE)));
+    }
+
+    static constexpr unsigned int DIGEST_SIZE = Traits::DIGEST_SIZE;
+    static constexpr unsigned int BLOCK_SIZE = Traits::BLOCK_SIZE;
+};
+
+/*
+ * Writes exactly 2*N lowercase hex characters (no terminator) into a caller
+ * supplied buffer, returning the position just past them.
+ */
+template <size_t N>
+constexpr char* sha2ToHex(const std::array<uint8_t, N>& digest, char *out)
+{
+    const char hex[] = "0123456789abcdef";
+    for (size_t i = 0; i < N; i++) {
+        *out++ = hex[digest[i] >> 4];
+        *out++ = hex[digest[i] & 0x0f];
+    }
+    return out;
+}
+
+template <typename Hash>
+constexpr std::array<uint8_t, Hash::DIGEST_SIZE> sha2Digest(std::string_view input)
+{
+    std::array<uint8_t, Hash::DIGEST_SIZE> digest{};
+    Hash ctx = Hash();
+    ctx.init();
+    ctx.update(input);
+    ctx.final(digest.data());
+    return digest;
+}
+
+template <typename Hash>
+std::string sha2Hex(std::string_view input)
+{
+    std::string hex(2 * Hash::DIGEST_SIZE, '0');
+    sha2ToHex(sha2Digest<Hash>(input), hex.data());
+    return hex;
+}
+#endif
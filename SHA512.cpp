@@ -0,0 +1,168 @@
+/*
+ * SHA-512 and SHA-512/256, on the SHA-2 core shared with SHA256.
+ *
+ * On 64-bit cores SHA-512 processes 128 byte blocks with 64-bit words, so it
+ * moves more data per round than SHA-256 and usually wins per byte (unless
+ * the CPU has SHA-256 instructions).  SHA-512/256 keeps that speed with a
+ * 256-bit digest.  sha2Benchmark() measures each backend per message size on
+ * the running machine, and sha2Fastest() picks from those measurements.
+ *
+ * Based on Olivier Gay's FIPS 180-2 implementation; see SHA256.cpp for the
+ * Modified BSD License.
+ */
+
+#include <chrono>
+#include "SHA512.h"
+#include "SHA256.h"
+
+std::string sha512(std::string_view input)
+{
+    return sha2Hex<SHA512>(input);
+}
+
+std::string sha512_256(std::string_view input)
+{
+    return sha2Hex<SHA512_256>(input);
+}
+
+// Hashes one message repeatedly for about 'seconds', returning bytes/second.
+template <typename Hash>
+static double sha2Throughput(const std::string& message, double seconds)
+{
+    typedef std::chrono::steady_clock clock;
+    unsigned char digest[Hash::DIGEST_SIZE];
+    unsigned long long rounds = 0;
+    double elapsed = 0;
+    clock::time_point start = clock::now();
+
+    do {
+        for (int i = 0; i < 16; i++) {
+            Hash ctx = Hash();
+            ctx.init();
+            ctx.update(message);
+            ctx.final(digest);
+        }
+        rounds += 16;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < seconds);
+
+    // Keep the optimizer from discarding the work
+    volatile unsigned char sink = digest[0];
+    (void) sink;
+    return (double) rounds * (double) message.size() / elapsed;
+}
+
+std::vector<SHA2BenchResult> sha2Benchmark(const std::vector<size_t>& sizes, double secondsPerCase)
+{
+    std::vector<SHA2BenchResult> results;
+
+    for (size_t size : sizes) {
+        std::string message(size, 'x');
+        results.push_back({"SHA-256", 128, size, sha2Throughput<SHA256>(message, secondsPerCase)});
+        results.push_back({"SHA-512/256", 128, size, sha2Throughput<SHA512_256>(message, secondsPerCase)});
+        results.push_back({"SHA-512", 256, size, sha2Throughput<SHA512>(message, secondsPerCase)});
+    }
+    return results;
+}
+
+/*
+ * Returns the name of the fastest backend with at least securityBits of
+ * collision resistance, measured at the benchmarked size closest to
+ * messageSize.  Returns an empty string if nothing qualifies.
+ */
+std::string sha2Fastest(const std::vector<SHA2BenchResult>& results, unsigned int securityBits, size_t messageSize)
+{
+    const SHA2BenchResult *best = nullptr;
+    size_t nearest = 0;
+    bool found = false;
+
+    for (const SHA2BenchResult& r : results) {
+        size_t distance = r.messageSize > messageSize ? r.messageSize - messageSize : messageSize - r.messageSize;
+        if (!found || distance < nearest) {
+            nearest = distance;
+            found = true;
+        }
+    }
+
+    for (const SHA2BenchResult& r : results) {
+        size_t distance = r.messageSize > messageSize ? r.messageSize - messageSize : messageSize - r.messageSize;
+        if (distance != nearest || r.securityBits < securityBits)
+            continue;
+        if (best == nullptr || r.bytesPerSecond > best->bytesPerSecond)
+            best = &r;
+    }
+    return best == nullptr ? "" : best->name;
+}
+
+// Hashes message in two parts, exporting the state after the first and
+// importing it into a new context for the second; compares with one shot.
+template <typename Hash>
+static bool sha2ResumeMatches(const std::string& message, size_t split)
+{
+    std::array<uint8_t, Hash::DIGEST_SIZE> resumed{};
+    Hash first = Hash();
+    Hash second = Hash();
+
+    first.init();
+    first.update(std::string_view(message).substr(0, split));
+    std::vector<unsigned char> blob = first.exportState();
+    if (!second.importState(blob))
+        return false;
+    second.update(std::string_view(message).substr(split));
+    second.final(resumed.data());
+    return resumed == sha2Digest<Hash>(message);
+}
+
+// A blob of another version, or of another algorithm, must be refused and
+// leave the context as it was.
+template <typename Hash, typename Other>
+static bool sha2RejectsForeignState(const std::string& message)
+{
+    std::array<uint8_t, Hash::DIGEST_SIZE> digest{};
+    Hash ctx = Hash();
+    Other other = Other();
+
+    ctx.init();
+    ctx.update(message);
+    std::vector<unsigned char> blob = ctx.exportState();
+    blob[0]++;
+    if (ctx.importState(blob))
+        return false;
+
+    other.init();
+    other.update("something else");
+    if (ctx.importState(other.exportState()))
+        return false;
+
+    ctx.final(digest.data());
+    return digest == sha2Digest<Hash>(message);
+}
+
+template <typename Hash>
+static bool sha2StateTests(const std::string& message)
+{
+    static const size_t splits[] = { 0, 63, 64, 65, 127, 128, 129 };
+
+    for (size_t split : splits) {
+        if (!sha2ResumeMatches<Hash>(message, split))
+            return false;
+    }
+    return sha2ResumeMatches<Hash>(message, message.size());
+}
+
+/*
+ * Split-and-resume hashing through exportState() / importState() matches
+ * single-shot hashing for each SHA-2 backend, at and around block
+ * boundaries; foreign blobs are rejected.
+ */
+bool doSHA2UnitTests()
+{
+    std::string message(300, '\0');
+    for (size_t i = 0; i < message.size(); i++)
+        message[i] = (char) (i * 31 + 7);
+
+    return sha2StateTests<SHA256>(message) && sha2StateTests<SHA512>(message) && sha2StateTests<SHA512_256>(message)
+        && sha2RejectsForeignState<SHA256, SHA512>(message)
+        && sha2RejectsForeignState<SHA512, SHA512_256>(message)
+        && sha2RejectsForeignState<SHA512_256, SHA512>(message);
+}
@@ -0,0 +1,132 @@
+#ifndef SHA512_H
+#define SHA512_H
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include "SHA2Core.h"
+#include "SHA256.h"
+
+#define SHA512_F1(x) (SHA2_ROTR(x, 28) ^ SHA2_ROTR(x, 34) ^ SHA2_ROTR(x, 39))
+#define SHA512_F2(x) (SHA2_ROTR(x, 14) ^ SHA2_ROTR(x, 18) ^ SHA2_ROTR(x, 41))
+#define SHA512_F3(x) (SHA2_ROTR(x,  1) ^ SHA2_ROTR(x,  8) ^ SHA2_SHFR(x,  7))
+#define SHA512_F4(x) (SHA2_ROTR(x, 19) ^ SHA2_ROTR(x, 61) ^ SHA2_SHFR(x,  6))
+
+struct SHA512Traits
+{
+    typedef unsigned long long word;
+    static const unsigned int ROUNDS = 80;
+    static const unsigned int BLOCK_SIZE = (1024/8);
+    static const unsigned int DIGEST_SIZE = (512/8);
+    static const unsigned char STATE_ID = 2;
+
+    static constexpr word K[80] =
+            {0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL,
+             0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+             0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL,
+             0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+             0xd807aa98a3030242ULL, 0x12835b0145706fbeULL,
+             0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+             0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL,
+             0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+             0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL,
+             0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+             0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL,
+             0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+             0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL,
+             0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+             0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
+             0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+             0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL,
+             0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+             0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL,
+             0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+             0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL,
+             0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+             0xd192e819d6ef5218ULL, 0xd69906245565a910ULL,
+             0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+             0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL,
+             0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+             0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL,
+             0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+             0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL,
+             0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+             0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL,
+             0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+             0xca273eceea26619cULL, 0xd186b8c721c0c207ULL,
+             0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+             0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL,
+             0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+             0x28db77f523047d84ULL, 0x32caab7b40c72493ULL,
+             0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+             0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL,
+             0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL};
+
+    static constexpr word H0[8] =
+            {0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+             0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+             0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+             0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL};
+
+    static constexpr word f1(word x) { return SHA512_F1(x); }
+    static constexpr word f2(word x) { return SHA512_F2(x); }
+    static constexpr word f3(word x) { return SHA512_F3(x); }
+    static constexpr word f4(word x) { return SHA512_F4(x); }
+};
+
+// SHA-512/256 (FIPS 180-4): the SHA-512 compression with its own initial
+// hash value, truncated to 256 bits.  Same security level as SHA-256, but
+// faster on 64-bit cores without SHA extensions.
+struct SHA512_256Traits : public SHA512Traits
+{
+    static const unsigned int DIGEST_SIZE = (256/8);
+    static const unsigned char STATE_ID = 3;
+
+    static constexpr word H0[8] =
+            {0x22312194fc2bf72cULL, 0x9f555fa3c84c64c2ULL,
+             0x2393b86b6f53b151ULL, 0x963877195940eabdULL,
+             0x96283ee2a88effe3ULL, 0xbe5e1e2553863992ULL,
+             0x2b0199fc2c85b8aaULL, 0x0eb72ddc81c52ca2ULL};
+};
+
+class SHA512 : public SHA2Core<SHA512Traits>
+{
+};
+
+class SHA512_256 : public SHA2Core<SHA512_256Traits>
+{
+};
+
+typedef std::array<uint8_t, SHA512::DIGEST_SIZE> SHA512Digest;
+
+constexpr SHA512Digest sha512Digest(std::string_view input)
+{
+    return sha2Digest<SHA512>(input);
+}
+
+constexpr SHA256Digest sha512_256Digest(std::string_view input)
+{
+    return sha2Digest<SHA512_256>(input);
+}
+
+std::string sha512(std::string_view input);
+std::string sha512_256(std::string_view input);
+
+/*
+ * Per message size throughput of each SHA-2 backend on this machine, so the
+ * fastest digest meeting a required security level can be chosen at runtime.
+ * securityBits is the collision resistance (half the digest length).
+ */
+struct SHA2BenchResult
+{
+    std::string name;
+    unsigned int securityBits;
+    size_t messageSize;
+    double bytesPerSecond;
+};
+
+std::vector<SHA2BenchResult> sha2Benchmark(const std::vector<size_t>& sizes, double secondsPerCase = 0.05);
+std::string sha2Fastest(const std::vector<SHA2BenchResult>& results, unsigned int securityBits, size_t messageSize);
+
+bool doSHA2UnitTests();
+#endif
@@ -1,430 +1,1654 @@
-/*
-* Class Sqlite
-* ============
-* Karim Sultan, September 2022.
-* 
-* This class is an API wrapper class in C++ for the sqlite3 database.
-* Using a simplified object oriented wrapper, one can easily manipulate
-* the sqlite3 database, including parametrical query substitution.
-* 
-* Most of the read/execute functionality comes in the Cursor class.
-* You can obtain a cursor from an open database, done via the connect() method:
-* 
--->
-gamzia::Sqlite* db = new (std::nothrow) gamzia::Sqlite("mydb_name.db");
-
-db->connect();
-gamzia::Cursor k = db->getCursor();
-<--
-
-*
-* with the cursor you can write and read:
-* 
--->
-std::string sql = "CREATE TABLE employees (ID INTEGER PRIMARY KEY AUTOINCREMENT, name, salary)";
-k.execute(sql);
-k.commit;
-
-// add an employees ...
-sql = "INSERT INTO employees (name, salary) VALUES (?, ?)";
-std::string name, salary;
-std::vector<std::string> params;
-name="Bob";
-salary="100,000";
-params.push_back(name);
-params.push_back(salary);
-k.execute(sql, params);
-
-// Read table (first row is column headers)
-sql = "SELECT * FROM employees";
-k.execute(sql);
-
-std::vector<std::string> table;
-table = k.fetchAll();
-
-// or ... read as single row
-// Row pointer will increment for the next read, and return empty on no more data.
-std::vector<std::string> row;
-row = k.fetchOne();
-
-// Close the DB
-db->close();
-
-<--
-*
-* NOTE: Field types -> regardless of field type, the data is read as and returned as 
-* text (std::string).  You can provide conversions after the fact as required.
-* 
-* DEPENDENCY: sqlite3.dll
-*/
-
-#include <string>
-#include <sstream>
-#include <iostream>
-#include <vector>
-#include "Sqlite.h"
-#include "sqlite3.h"
-
-
-/*****************
-*  Class Sqlite  *
-*****************/
-
-gamzia::Sqlite::Sqlite()
-{
-   mydbname = "";
-   mydb = nullptr;
-   isConnected = false;
-}
-
-gamzia::Sqlite::Sqlite(std::string dbname)
-{
-   // Store database name
-   mydbname = dbname;
-   mydb = nullptr;
-   isConnected = false;
-}
-
-gamzia::Sqlite::~Sqlite()
-{
-   if (isConnected == true)
-      sqlite3_close (mydb);
-}
-
-std::string gamzia::Sqlite::getLastError()
-{
-   std::stringstream ss;
-   ss << "[" << sqlite3_errcode(mydb) << "]  " << sqlite3_errmsg(mydb);
-   return (ss.str());
-}
-
-bool gamzia::Sqlite::connect()
-{
-   int rc=sqlite3_open(mydbname.c_str(), &mydb);
-   if (rc != SQLITE_OK)
-   {
-      isConnected=false;
-      myerror = sqlite3_errmsg(mydb);
-   }
-   else
-      isConnected = true;
-
-   return(isConnected);
-}
-
-gamzia::Cursor gamzia::Sqlite::getCursor()
-{
-   if (!isConnected)
-      // DB not open, can't setup cursor
-      return nullptr;
-
-   Cursor mycursor = gamzia::Cursor(mydb);
-   return (mycursor);
-}
-
-void gamzia::Sqlite::close()
-{
-   sqlite3_close (mydb);
-   isConnected = false;
-}
-
-/*****************
-*  Class Cursor  *
-*****************/
-
-gamzia::Cursor::Cursor(sqlite3* db)
-{
-   mydb = db;
-   statement = nullptr;
-}
-
-gamzia::Cursor::~Cursor()
-{
-   sqlite3_reset (statement);
-   sqlite3_finalize (statement);
-   statement = nullptr;
-}
-
-bool gamzia::Cursor::doesTableExist(std::string table)
-{
-   std::string sql;
-   std::vector<std::string> params;
-
-   // Sanity
-   if (table.empty())
-     return false;
-
-   // Our pragma select, finds the table or not.
-   sql = "select * from pragma_table_list where name = ?";
-   params.clear();
-   params.push_back(table);
-   execute(sql, params);
-   if (fetchOne().empty())
-      return false;
-   
-   // Table exists
-   return true;
-}
-
-/// <summary>
-/// Helper method to perform a Commit (finalizes the db changes).
-/// </summary>
-/// <returns>True on success.</returns>
-bool gamzia::Cursor::commit()
-{
-   return(execute("COMMIT;"));
-}
-
-/// <summary>
-/// Helper method to peform a rollback (reverses the transaction).
-/// </summary>
-/// <returns>True on success.</returns>
-bool gamzia::Cursor::rollback()
-{
-   return(execute("ROLLBACK;"));
-}
-
-/// <summary>
-/// Helper method to perform a vacuum (compacts the database reclaiming free space).
-/// </summary>
-/// <returns></returns>
-bool gamzia::Cursor::vacuum()
-{
-   return(execute("VACUUM;"));
-}
-
-/// <summary>
-/// Executes a query.  See the params version for information
-/// on how command vs query queries are handled.
-/// </summary>
-/// <param name="sql">The SQL command to execute.</param>
-/// <returns>True if success, false otherwise.</returns>
-bool gamzia::Cursor::execute(std::string sql)
-{
-   int rc;
-
-   // Free the old statement to prevent memory leaks, if one exists
-   //if (statement != nullptr)
-   //   sqlite3_finalize(statement);
-
-   rc = sqlite3_prepare_v2(mydb, sql.c_str(), -1, &statement, NULL);
-   if (rc != SQLITE_OK)
-      return false;
-
-   // Execute; reset in case rows are available
-   sqlite3_step(statement);
-   sqlite3_reset(statement);
-   return true;
-}
-
-/// <summary>
-/// Scans SQL Query for ? and replaces them with params.  Performs mild sanitization
-/// on params.  Only replaces '?' placeholders; does not handle variable names.
-/// </summary>
-/// <param name="sql">An SQL query with ? placeholders.</param>
-/// <param name="params">A vector of params.  Must have enough params to replace all '?'s.</param>
-/// <returns>True if statement prepared, false otherwise.</returns>
-bool gamzia::Cursor::execute(std::string sql, const std::vector<std::string> params)
-{
-   int        numParams = 0;
-   int                x = 0;
-   int               rc;
-   std::string variable;
-
-   // Count number of '?'s
-   while ((x = (int)sql.find('?', x+1)) != std::string::npos)
-      numParams++;
-
-   // Sanity
-   if ((int)params.size() < numParams)
-      return false;
-
-   // Bind
-   for (int i = 0; i < numParams; i++)
-   {
-      // Sanitize
-      variable = params[i];
-      while ((x = (int)variable.find(';', 0)) != std::string::npos)
-         variable.erase(x, 1);
-      variable = "'" + variable + "'";
-
-      // Get location in string
-      x = (int)sql.find('?', 0);
-      
-      // Replace the ? with variable
-      sql.replace(x, 1, variable);
-   }
-
-   // Terminate with semicolon if needed
-   if (sql[sql.size() - 1] != ';')
-      sql += ';';
-
-   // Prepare statement
-   rc = sqlite3_prepare_v2(mydb, sql.c_str(), -1, &statement, NULL);
-   if (rc != SQLITE_OK)
-      return false;
-
-   // We need to process prepared statement for any immediate actions;
-   // ie, such as dropping a table, inserting a value, or anything that
-   // doesn't return a row.
-   sqlite3_step(statement);
-
-   // However, had we just had a SELECT, or any query that returns rows,
-   // we would miss the first row in fetchOne() as it will do another step.
-   // Fortunately, the sqlite API has a 'reset' which just repositions the
-   // cursor but does not undo bindings.
-   sqlite3_reset(statement);
-
-   return true;
-}
-
-/*
-* // Leaving this in as a starting point for resumption; however, the API was 
-* // unreliable when binding parameters through the sqlite engine, hence
-* // this was replaced.
-bool gamzia::Cursor::execute (std::string sql, const std::vector<std::string> params)
-{
-   unsigned int numParams;
-   int          rc;
-
-   rc = sqlite3_prepare_v2(mydb, sql.c_str(), -1, &statement, NULL);
-   if (rc != SQLITE_OK)
-      return false;
-
-   numParams = sqlite3_bind_parameter_count(statement);
-   if (params.size() < numParams)
-      return false;
-
-   for (unsigned int i = 1; i <= numParams; i++)
-   {
-      sqlite3_bind_text(statement, i, params[i-1].c_str(), -1, SQLITE_STATIC);
-   }
-
-   return (true);
-}
-*/
-
-/// <summary>
-/// If available, fetches a row of data as a vector of string.  This version
-/// does not return a map, so no column names are available.
-/// </summary>
-/// <returns>A vector representing a row of data.</returns>
-std::vector<std::string> gamzia::Cursor::fetchOne()
-{
-   std::vector<std::string> row;
-
-   int rc = sqlite3_step(statement);
-   if (rc != SQLITE_DONE)
-   {
-      int columns = sqlite3_column_count(statement);
-      for (int i= 0; i<columns; i++)
-      {
-         std::stringstream ss;
-
-         const unsigned char* value = sqlite3_column_text(statement, i);
-
-         // Unfortunately, values can be NULL in db.
-         // Intercept and substitute space
-         if (value == nullptr)
-            row.push_back("");
-         else
-         {
-            // Convert to string and vectorize
-            ss << value;
-            row.push_back(ss.str());
-         }
-      }
-   }
-   else
-   {
-      // No data. Send empty row back.
-      row.clear();
-   }
-
-   return (row);
-}
-
-/// <summary>
-/// Returns all records read in a single vector of string.  If the vector
-/// has multiple rows, it will continue to place it in the vector.
-/// So, field 1 in a 4 field table would be at index 0, 4, 8, 12 etc...
-/// Column IDs are included as the first row.
-/// </summary>
-/// <returns>The entire table as a vector of string.</returns>
-std::vector<std::string> gamzia::Cursor::fetchAll()
-{
-   std::vector<std::string> table;
-   std::string name;
-
-   table.clear();
-
-   // Sanity
-   if (statement == nullptr)
-      return (table);
-
-   int rc = sqlite3_step(statement);
-   if (rc != SQLITE_DONE)
-   {
-      // Get column IDs, but just once
-      int columns = sqlite3_column_count(statement);
-      for (int i = 0; i < columns; i++)
-      {
-         name = std::string(sqlite3_column_name(statement, i));
-         table.push_back(name);
-      }
-   }
-
-   while (rc != SQLITE_DONE)
-   {
-      int columns = sqlite3_column_count(statement);
-      for (int i = 0; i < columns; i++)
-      {
-         std::stringstream ss;
-
-         const unsigned char* value = sqlite3_column_text(statement, i);
-
-         // Unfortunately, values can be NULL in db.
-         // Intercept and substitute space
-         if (value == nullptr)
-            table.push_back("");
-         else
-         {
-            // Convert to string, vectorize
-            ss << value;
-            table.push_back(ss.str());
-         }
-      }
-
-      rc = sqlite3_step(statement);
-   }
-
-   return (table);
-}
-
-/// <summary>
-/// Returns the column names in a vector of string.
-/// </summary>
-/// <returns></returns>
-std::vector<std::string> gamzia::Cursor::getColumnNames()
-{
-   std::vector<std::string> names;
-
-   int rc = sqlite3_step(statement);
-   while (rc != SQLITE_DONE)
-   {
-      int columns = sqlite3_column_count(statement);
-      for (int i = 0; i < columns; i++)
-      {
-         const char* columnName = sqlite3_column_name(statement, i);
-         names.push_back(std::string(columnName));
-      }
-   }
-
-   // Reset for row reading with fetchOne().
-   sqlite3_reset(statement);
-   return(names);
-}
-
-
-
-
+/*
+* Class Sqlite
+* ============
+* Karim Sultan, September 2022.
+* 
+* This class is an API wrapper class in C++ for the sqlite3 database.
+* Using a simplified object oriented wrapper, one can easily manipulate
+* the sqlite3 database, including parameter binding on prepared statements.
+* 
+* Most of the read/execute functionality comes in the Cursor class.
+* You can obtain a cursor from an open database, done via the connect() method:
+* 
+-->
+gamzia::Sqlite* db = new (std::nothrow) gamzia::Sqlite("mydb_name.db");
+
+db->connect();
+gamzia::Cursor k = db->getCursor();
+<--
+
+*
+* with the cursor you can write and read:
+* 
+-->
+std::string sql = "CREATE TABLE employees (ID INTEGER PRIMARY KEY AUTOINCREMENT, name, salary)";
+k.execute(sql);
+k.commit;
+
+// add an employees ...
+sql = "INSERT INTO employees (name, salary) VALUES (?, ?)";
+std::string name, salary;
+std::vector<std::string> params;
+name="Bob";
+salary="100,000";
+params.push_back(name);
+params.push_back(salary);
+k.execute(sql, params);
+
+// ... or many, on one statement and in batched transactions
+std::vector<std::vector<std::string>> rows = { {"Alice", "90,000"}, {"Carol", "95,000"} };
+k.executeMany(sql, rows);
+
+// Read table (first row is column headers)
+sql = "SELECT * FROM employees";
+k.execute(sql);
+
+std::vector<std::string> table;
+table = k.fetchAll();
+
+// or ... read as single row
+// Row pointer will increment for the next read, and return empty on no more data.
+std::vector<std::string> row;
+row = k.fetchOne();
+
+// or ... stream the rows lazily, without materializing the table
+for (gamzia::Row r : k.query("SELECT name, salary FROM employees"))
+   std::cout << r.getText(0) << " " << r.getText(1) << std::endl;
+
+// Stream a large BLOB in pieces, rather than fetching it as one string
+gamzia::BlobStream blob = k.openBlob("employees", "photo", rowid);
+blob.forEachChunk([&](std::span<const std::byte> chunk) { out.write((const char*)chunk.data(), chunk.size()); return true; });
+
+// Compute inside the query with a C++ function, rather than fetching rows
+// out and writing them back
+db->registerFunction("raise", [](double salary, double percent) { return salary * (1 + percent / 100); });
+k.execute("UPDATE employees SET salary = raise(salary, 3)");
+
+// Close the DB
+db->close();
+
+<--
+*
+* NOTE: Field types -> regardless of field type, the data is read as and returned as 
+* text (std::string).  You can provide conversions after the fact as required.
+* 
+* NOTE: Statement cache -> each connection keeps an LRU cache of prepared
+* statements keyed by SQL text (STATEMENT_CACHE_SIZE entries by default).
+* Executing the same SQL again reuses the compiled statement, so prefer
+* '?' parameters over building SQL strings with values in them.  Hit and
+* miss counts are available from getStatementCacheStats().
+* 
+* NOTE: Cursors are move-only.  A cursor owns at most one statement at a
+* time: executing the same SQL again resets and reuses it, and different SQL
+* hands it back to the cache first.  getCursor() on a closed database gives
+* a detached cursor (isValid() is false) on which every call fails.
+* 
+* NOTE: Change notifications -> subscribe() reports the rowids each committed
+* transaction inserted, updated or deleted, in one batch per transaction
+* (see ChangeFeed); ie, to invalidate exactly the cached rows that changed.
+* 
+* DEPENDENCY: sqlite3.dll
+*/
+
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include "Sqlite.h"
+#include "sqlite3.h"
+
+
+/*****************
+*  Class Sqlite  *
+*****************/
+
+gamzia::Sqlite::Sqlite()
+{
+   mydbname = "";
+   mydb = nullptr;
+   isConnected = false;
+   mycachesize = STATEMENT_CACHE_SIZE;
+}
+
+gamzia::Sqlite::Sqlite(std::string dbname)
+{
+   // Store database name
+   mydbname = dbname;
+   mydb = nullptr;
+   isConnected = false;
+   mycachesize = STATEMENT_CACHE_SIZE;
+}
+
+gamzia::Sqlite::~Sqlite()
+{
+   // A failed open still allocates a handle (it carries the error message)
+   if (isConnected == true || mydb != nullptr)
+      close();
+}
+
+/// <summary>
+/// Move constructor.  The connection (and its statement cache) is taken
+/// over; the source is left disconnected.
+/// </summary>
+gamzia::Sqlite::Sqlite(Sqlite&& other) noexcept
+{
+   mydbname = std::move(other.mydbname);
+   mydb = other.mydb;
+   isConnected = other.isConnected;
+   myerror = std::move(other.myerror);
+   mycachesize = other.mycachesize;
+   mycache = std::move(other.mycache);
+   myprofiler = std::move(other.myprofiler);
+   myfeed = std::move(other.myfeed);
+
+   other.mydb = nullptr;
+   other.isConnected = false;
+}
+
+/// <summary>
+/// Move assignment.  Closes this connection first if it is open.
+/// </summary>
+gamzia::Sqlite& gamzia::Sqlite::operator=(Sqlite&& other) noexcept
+{
+   if (this != &other)
+   {
+      if (isConnected)
+         close();
+
+      mydbname = std::move(other.mydbname);
+      mydb = other.mydb;
+      isConnected = other.isConnected;
+      myerror = std::move(other.myerror);
+      mycachesize = other.mycachesize;
+      mycache = std::move(other.mycache);
+      myprofiler = std::move(other.myprofiler);
+      myfeed = std::move(other.myfeed);
+
+      other.mydb = nullptr;
+      other.isConnected = false;
+   }
+   return (*this);
+}
+
+std::string gamzia::Sqlite::getLastError()
+{
+   std::stringstream ss;
+   ss << "[" << sqlite3_errcode(mydb) << "]  " << sqlite3_errmsg(mydb);
+   return (ss.str());
+}
+
+bool gamzia::Sqlite::connect()
+{
+   return (connect(SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE));
+}
+
+/// <summary>
+/// Opens the database with explicit sqlite3_open_v2 flags, ie:
+/// SQLITE_OPEN_READONLY, or SQLITE_OPEN_NOMUTEX for a connection that is
+/// only ever used by one thread at a time (see ConnectionPool).
+/// </summary>
+/// <param name="flags">SQLITE_OPEN_* flags.</param>
+/// <returns>True if connected.</returns>
+bool gamzia::Sqlite::connect(int flags)
+{
+   int rc=sqlite3_open_v2(mydbname.c_str(), &mydb, flags, NULL);
+   if (rc != SQLITE_OK)
+   {
+      isConnected=false;
+      myerror = sqlite3_errmsg(mydb);
+   }
+   else
+   {
+      isConnected = true;
+      mycache = std::make_shared<StatementCache>(mydb, mycachesize);
+      myfeed = std::make_shared<ChangeFeed>(mydb);
+   }
+
+   return(isConnected);
+}
+
+gamzia::Cursor gamzia::Sqlite::getCursor()
+{
+   if (!isConnected)
+      // DB not open, can't setup cursor; a detached one fails every call
+      return (gamzia::Cursor());
+
+   return (gamzia::Cursor(mydb, mycache, myprofiler, myfeed));
+}
+
+/// <summary>
+/// Returns the raw sqlite3 connection handle, for modules that need the
+/// C API directly (ie, incremental blob I/O).  Null if not connected.
+/// </summary>
+/// <returns>The connection handle.</returns>
+sqlite3* gamzia::Sqlite::getHandle()
+{
+   if (!isConnected)
+      return nullptr;
+   return (mydb);
+}
+
+/// <summary>
+/// Sets how long a statement waits on a lock held by another connection
+/// before failing with SQLITE_BUSY.  0 fails immediately.
+/// </summary>
+/// <param name="milliseconds">Maximum wait.</param>
+/// <returns>True on success.</returns>
+bool gamzia::Sqlite::setBusyTimeout(int milliseconds)
+{
+   if (!isConnected)
+      return false;
+   return (sqlite3_busy_timeout(mydb, milliseconds) == SQLITE_OK);
+}
+
+/// <summary>
+/// Sets the journal mode ("WAL", "DELETE", "TRUNCATE", ...).  WAL lets
+/// readers run while a writer commits.  The pragma answers with the mode
+/// actually in effect, which is checked: some databases (ie, :memory:)
+/// cannot use WAL.
+/// </summary>
+/// <param name="mode">The journal mode.</param>
+/// <returns>True if the mode is now in effect.</returns>
+bool gamzia::Sqlite::setJournalMode(std::string mode)
+{
+   std::vector<std::string> row;
+
+   if (!isConnected)
+      return false;
+
+   // The mode is pasted into the pragma; accept letters only
+   for (char& c : mode)
+   {
+      if (!isalpha((unsigned char)c))
+         return false;
+      c = (char)tolower((unsigned char)c);
+   }
+
+   gamzia::Cursor k = getCursor();
+   if (!k.execute("PRAGMA journal_mode=" + mode))
+      return false;
+   row = k.fetchOne();
+   return (!row.empty() && row[0] == mode);
+}
+
+/// <summary>
+/// Sets the number of prepared statements kept per connection.
+/// 0 disables caching (every execute prepares, as before).
+/// </summary>
+/// <param name="size">Maximum number of cached statements.</param>
+void gamzia::Sqlite::setStatementCacheSize(size_t size)
+{
+   mycachesize = size;
+   if (mycache)
+      mycache->setCapacity(size);
+}
+
+/// <summary>
+/// Returns the statement cache's hit, miss and eviction counts.
+/// </summary>
+gamzia::StatementCacheStats gamzia::Sqlite::getStatementCacheStats()
+{
+   if (mycache)
+      return (mycache->getStats());
+
+   StatementCacheStats stats = StatementCacheStats();
+   stats.capacity = mycachesize;
+   return (stats);
+}
+
+/// <summary>
+/// Attaches a QueryProfiler; cursors obtained afterwards record every
+/// execution into it.  One profiler may be shared by several connections.
+/// nullptr detaches it.
+/// </summary>
+/// <param name="profiler">The profiler.</param>
+void gamzia::Sqlite::setProfiler(std::shared_ptr<QueryProfiler> profiler)
+{
+   myprofiler = profiler;
+}
+
+std::shared_ptr<gamzia::QueryProfiler> gamzia::Sqlite::getProfiler()
+{
+   return (myprofiler);
+}
+
+/// <summary>
+/// Copies this database into destination with the online backup API,
+/// replacing destination's contents; ie, load a file into ":memory:", or
+/// save ":memory:" to a file.  Copies pagesPerStep pages at a time (-1 for
+/// all at once) and sleeps sleepMillis between steps, so other connections
+/// can use the source meanwhile.  If another connection writes to the
+/// source mid-copy, the copy restarts by itself.  On failure, the reason is
+/// in destination.getLastError().
+/// </summary>
+/// <param name="destination">An open database.</param>
+/// <param name="pagesPerStep">Pages per step; -1 copies in one step.</param>
+/// <param name="sleepMillis">Pause between steps.</param>
+/// <returns>True once the copy is complete.</returns>
+bool gamzia::Sqlite::backup(Sqlite& destination, int pagesPerStep, int sleepMillis)
+{
+   int rc = SQLITE_OK;
+   int busy = 0;
+
+   if (!isConnected || !destination.isConnected || this == &destination)
+      return false;
+
+   sqlite3_backup* copy = sqlite3_backup_init(destination.mydb, "main", mydb, "main");
+   if (copy == nullptr)
+      return false;
+
+   do
+   {
+      rc = sqlite3_backup_step(copy, pagesPerStep);
+      if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
+      {
+         // Someone holds a lock; retry for about five seconds
+         if (++busy > 5000)
+            break;
+         sqlite3_sleep(1);
+      }
+      else if (rc == SQLITE_OK && sleepMillis > 0)
+         sqlite3_sleep(sleepMillis);
+   } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+
+   // finish() leaves the error code on the destination connection
+   return (sqlite3_backup_finish(copy) == SQLITE_OK && rc == SQLITE_DONE);
+}
+
+/// <summary>
+/// PRAGMA data_version: changes whenever another connection commits to the
+/// database (this connection's own commits do not change it).  Compare two
+/// readings to tell whether a copy of the database is stale.
+/// </summary>
+/// <returns>The version, or -1 on error.</returns>
+long long gamzia::Sqlite::getDataVersion()
+{
+   return (pragmaInteger("PRAGMA data_version"));
+}
+
+/// <summary>
+/// Sets PRAGMA auto_vacuum ("none", "full" or "incremental").  With
+/// "incremental", pages freed by deletes stay in the file on a free list
+/// until Cursor::incrementalVacuum() hands a bounded number of them back,
+/// so space is reclaimed a little at a time rather than by a full VACUUM
+/// rewriting the file.  Best set before the first table is created: an
+/// existing database switching to or from "none" needs one full VACUUM to
+/// convert, which this runs.
+/// </summary>
+/// <param name="mode">The auto_vacuum mode.</param>
+/// <returns>True if the mode is now in effect.</returns>
+bool gamzia::Sqlite::setAutoVacuum(std::string mode)
+{
+   static const char* modes[] = { "none", "full", "incremental" };
+   long long wanted = -1;
+
+   if (!isConnected)
+      return false;
+
+   for (char& c : mode)
+      c = (char)tolower((unsigned char)c);
+   for (long long i = 0; i < 3; i++)
+   {
+      if (mode == modes[i])
+         wanted = i;
+   }
+   if (wanted == -1)
+      return false;
+   if (pragmaInteger("PRAGMA auto_vacuum") == wanted)
+      return true;
+
+   gamzia::Cursor k = getCursor();
+   if (!k.execute("PRAGMA auto_vacuum=" + mode))
+      return false;
+
+   // Only takes effect on an empty database, or after a VACUUM
+   if (pragmaInteger("PRAGMA auto_vacuum") != wanted && !k.vacuum())
+      return false;
+   return (pragmaInteger("PRAGMA auto_vacuum") == wanted);
+}
+
+/// <summary>
+/// PRAGMA freelist_count: pages in the file that hold no data, ie, left by
+/// deletes, and that incrementalVacuum() could return to the file system.
+/// </summary>
+/// <returns>The count, or -1 on error.</returns>
+long long gamzia::Sqlite::getFreePages()
+{
+   return (pragmaInteger("PRAGMA freelist_count"));
+}
+
+/// <summary>
+/// PRAGMA page_count: the size of the file, in pages.
+/// </summary>
+/// <returns>The count, or -1 on error.</returns>
+long long gamzia::Sqlite::getPageCount()
+{
+   return (pragmaInteger("PRAGMA page_count"));
+}
+
+/// <summary>
+/// Runs a pragma that answers with one integer.  Prepared by hand so that
+/// housekeeping checks stay out of the profiler and the statement cache.
+/// </summary>
+/// <returns>The value, or -1 on error.</returns>
+long long gamzia::Sqlite::pragmaInteger(const char* pragma)
+{
+   sqlite3_stmt* statement = nullptr;
+   long long value = -1;
+
+   if (!isConnected)
+      return (-1);
+
+   if (sqlite3_prepare_v2(mydb, pragma, -1, &statement, NULL) == SQLITE_OK &&
+      sqlite3_step(statement) == SQLITE_ROW)
+      value = sqlite3_column_int64(statement, 0);
+   sqlite3_finalize(statement);
+   return (value);
+}
+
+/// <summary>
+/// Subscribes to the rows changed by each committed transaction on this
+/// connection (see ChangeFeed), through any of its cursors, including
+/// ones obtained before subscribing.
+/// </summary>
+/// <param name="listener">Called, on the committing thread, per batch.</param>
+/// <param name="table">Only changes to this table; empty for all.</param>
+/// <returns>An id for unsubscribe(); 0 if not connected.</returns>
+int gamzia::Sqlite::subscribe(ChangeListener listener, std::string table)
+{
+   if (!isConnected || !myfeed)
+      return (0);
+   return (myfeed->subscribe(std::move(listener), std::move(table)));
+}
+
+bool gamzia::Sqlite::unsubscribe(int id)
+{
+   return (myfeed && myfeed->unsubscribe(id));
+}
+
+/// <summary>
+/// Delivers a committed batch now.  Cursors do this on their own; call it
+/// after committing through getHandle() (ie, sqlite3_exec("COMMIT")).
+/// </summary>
+void gamzia::Sqlite::flushChanges()
+{
+   if (myfeed)
+      myfeed->deliver();
+}
+
+/// <summary>
+/// Closes the connection.  Cached statements are finalized; statements still
+/// held by live cursors are finalized when those cursors let go of them
+/// (sqlite3_close_v2 keeps the handle alive until then).
+/// </summary>
+void gamzia::Sqlite::close()
+{
+   if (myfeed)
+   {
+      myfeed->detach();
+      myfeed.reset();
+   }
+   if (mycache)
+   {
+      mycache->close();
+      mycache.reset();
+   }
+   sqlite3_close_v2 (mydb);
+   mydb = nullptr;
+   isConnected = false;
+}
+
+/*************************
+*  Class StatementCache  *
+*************************/
+
+gamzia::StatementCache::StatementCache(sqlite3* db, size_t capacity)
+{
+   mydb = db;
+   mycapacity = capacity;
+   isClosed = false;
+   mystats = StatementCacheStats();
+}
+
+gamzia::StatementCache::~StatementCache()
+{
+   close();
+}
+
+/// <summary>
+/// Checks a prepared statement out of the cache, preparing it on a miss.
+/// A checked out statement belongs to the caller until release(), so two
+/// cursors running the same SQL never share (and reset) one statement.
+/// </summary>
+/// <param name="sql">The SQL text; this is the cache key.</param>
+/// <returns>The statement, or nullptr if it failed to prepare.</returns>
+sqlite3_stmt* gamzia::StatementCache::acquire(const std::string& sql)
+{
+   sqlite3_stmt* statement = nullptr;
+
+   auto found = myindex.find(sql);
+   if (found != myindex.end())
+   {
+      statement = found->second->second;
+      mylru.erase(found->second);
+      myindex.erase(found);
+      mystats.hits++;
+      return (statement);
+   }
+
+   mystats.misses++;
+   if (sqlite3_prepare_v3(mydb, sql.c_str(), (int)sql.size() + 1,
+      mycapacity > 0 ? SQLITE_PREPARE_PERSISTENT : 0, &statement, NULL) != SQLITE_OK)
+   {
+      sqlite3_finalize(statement);
+      return nullptr;
+   }
+   return (statement);
+}
+
+/// <summary>
+/// Returns a statement to the cache.  It is reset and its bindings cleared.
+/// If the cache already holds this SQL (or is closed or disabled) the
+/// statement is finalized instead.
+/// </summary>
+void gamzia::StatementCache::release(const std::string& sql, sqlite3_stmt* statement)
+{
+   if (statement == nullptr)
+      return;
+
+   if (isClosed || mycapacity == 0 || myindex.count(sql) > 0)
+   {
+      sqlite3_finalize(statement);
+      return;
+   }
+
+   sqlite3_reset(statement);
+   sqlite3_clear_bindings(statement);
+   mylru.push_front(std::make_pair(sql, statement));
+   myindex[sql] = mylru.begin();
+   trim();
+}
+
+void gamzia::StatementCache::setCapacity(size_t capacity)
+{
+   mycapacity = capacity;
+   trim();
+}
+
+gamzia::StatementCacheStats gamzia::StatementCache::getStats()
+{
+   StatementCacheStats stats = mystats;
+   stats.size = mylru.size();
+   stats.capacity = mycapacity;
+   return (stats);
+}
+
+/// <summary>
+/// Finalizes all cached statements; later releases finalize immediately.
+/// </summary>
+void gamzia::StatementCache::close()
+{
+   for (auto& entry : mylru)
+      sqlite3_finalize(entry.second);
+   mylru.clear();
+   myindex.clear();
+   isClosed = true;
+}
+
+/// <summary>
+/// Evicts least recently used statements down to capacity.
+/// </summary>
+void gamzia::StatementCache::trim()
+{
+   while (mylru.size() > mycapacity)
+   {
+      sqlite3_finalize(mylru.back().second);
+      myindex.erase(mylru.back().first);
+      mylru.pop_back();
+      mystats.evictions++;
+   }
+}
+
+/*****************
+*  Class Cursor  *
+*****************/
+
+/// <summary>
+/// A detached cursor, with no connection.  Every operation fails; this is
+/// what getCursor() returns when the database is not open.
+/// </summary>
+gamzia::Cursor::Cursor()
+{
+   mydb = nullptr;
+   statement = nullptr;
+   myprepnanos = 0;
+   mystepnanos = 0;
+   myrows = 0;
+}
+
+gamzia::Cursor::Cursor(sqlite3* db, std::shared_ptr<StatementCache> cache,
+   std::shared_ptr<QueryProfiler> profiler, std::shared_ptr<ChangeFeed> feed)
+{
+   mydb = db;
+   statement = nullptr;
+   mycache = cache;
+   myprofiler = profiler;
+   myfeed = feed;
+   myprepnanos = 0;
+   mystepnanos = 0;
+   myrows = 0;
+}
+
+/// <summary>
+/// Hands the owned statement back to the cache (or finalizes it).
+/// </summary>
+gamzia::Cursor::~Cursor()
+{
+   releaseStatement();
+}
+
+/// <summary>
+/// Move constructor.  A cursor owns at most one statement, so it cannot be
+/// copied (two owners would release it twice); moving transfers it and
+/// leaves the source detached.
+/// </summary>
+gamzia::Cursor::Cursor(Cursor&& other) noexcept
+{
+   mydb = other.mydb;
+   statement = other.statement;
+   mysql = std::move(other.mysql);
+   mycache = std::move(other.mycache);
+   myprofiler = std::move(other.myprofiler);
+   myfeed = std::move(other.myfeed);
+   myprepnanos = other.myprepnanos;
+   mystepnanos = other.mystepnanos;
+   myrows = other.myrows;
+
+   other.mydb = nullptr;
+   other.statement = nullptr;
+   other.mysql.clear();
+}
+
+/// <summary>
+/// Move assignment.  Releases this cursor's statement first.
+/// </summary>
+gamzia::Cursor& gamzia::Cursor::operator=(Cursor&& other) noexcept
+{
+   if (this != &other)
+   {
+      releaseStatement();
+      mydb = other.mydb;
+      statement = other.statement;
+      mysql = std::move(other.mysql);
+      mycache = std::move(other.mycache);
+      myprofiler = std::move(other.myprofiler);
+      myfeed = std::move(other.myfeed);
+      myprepnanos = other.myprepnanos;
+      mystepnanos = other.mystepnanos;
+      myrows = other.myrows;
+
+      other.mydb = nullptr;
+      other.statement = nullptr;
+      other.mysql.clear();
+   }
+   return (*this);
+}
+
+/// <summary>
+/// False for a detached cursor (no connection).
+/// </summary>
+bool gamzia::Cursor::isValid() const
+{
+   return (mydb != nullptr);
+}
+
+/// <summary>
+/// Hands the current statement back to the connection's statement cache
+/// (or finalizes it, if there is no cache).
+/// </summary>
+void gamzia::Cursor::releaseStatement()
+{
+   if (statement == nullptr)
+      return;
+
+   endProfile();
+   if (mycache)
+      mycache->release(mysql, statement);
+   else
+      sqlite3_finalize(statement);
+   statement = nullptr;
+   mysql.clear();
+}
+
+/// <summary>
+/// Obtains a prepared statement for sql: the one already owned if the SQL
+/// is unchanged (reset, bindings cleared), otherwise the previous one is
+/// released and a new one taken from the statement cache when possible.
+/// </summary>
+/// <returns>True if the statement is ready for binding.</returns>
+bool gamzia::Cursor::prepare(const std::string& sql)
+{
+   // Same SQL as last time: keep the statement, skip the cache round trip
+   if (statement != nullptr && sql == mysql)
+   {
+      endProfile();
+      sqlite3_reset(statement);
+      sqlite3_clear_bindings(statement);
+      return true;
+   }
+
+   releaseStatement();
+   if (mydb == nullptr)
+      return false;
+
+   std::chrono::steady_clock::time_point start;
+   if (myprofiler)
+      start = std::chrono::steady_clock::now();
+
+   if (mycache)
+      statement = mycache->acquire(sql);
+   else if (sqlite3_prepare_v2(mydb, sql.c_str(), -1, &statement, NULL) != SQLITE_OK)
+   {
+      sqlite3_finalize(statement);
+      statement = nullptr;
+   }
+
+   if (statement == nullptr)
+      return false;
+   mysql = sql;
+   if (myprofiler)
+      myprepnanos = (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+         std::chrono::steady_clock::now() - start).count();
+   return true;
+}
+
+/// <summary>
+/// Runs a bound statement.  Statements that return no columns (INSERT,
+/// UPDATE, CREATE, COMMIT...) are stepped to completion here.  Statements
+/// that return rows are left positioned before the first row, for fetchOne()
+/// and fetchAll() to step through.
+/// </summary>
+/// <returns>True on success.</returns>
+bool gamzia::Cursor::run()
+{
+   int rc;
+
+   if (sqlite3_column_count(statement) > 0)
+      return true;
+
+   rc = stepStatement();
+   sqlite3_reset(statement);
+   return (rc == SQLITE_DONE || rc == SQLITE_ROW);
+}
+
+bool gamzia::Cursor::doesTableExist(std::string table)
+{
+   std::string sql;
+   std::vector<std::string> params;
+
+   // Sanity
+   if (table.empty())
+     return false;
+
+   // Our pragma select, finds the table or not.
+   sql = "select * from pragma_table_list where name = ?";
+   params.clear();
+   params.push_back(table);
+   execute(sql, params);
+   if (fetchOne().empty())
+      return false;
+   
+   // Table exists
+   return true;
+}
+
+/// <summary>
+/// Helper method to perform a Commit (finalizes the db changes).
+/// In autocommit mode (no BEGIN issued) every statement is already
+/// committed, so there is nothing to do.
+/// </summary>
+/// <returns>True on success.</returns>
+bool gamzia::Cursor::commit()
+{
+   if (mydb != nullptr && sqlite3_get_autocommit(mydb))
+      return true;
+   return(execute("COMMIT;"));
+}
+
+/// <summary>
+/// Helper method to peform a rollback (reverses the transaction).
+/// In autocommit mode there is no open transaction to reverse.
+/// </summary>
+/// <returns>True on success.</returns>
+bool gamzia::Cursor::rollback()
+{
+   if (mydb != nullptr && sqlite3_get_autocommit(mydb))
+      return true;
+   return(execute("ROLLBACK;"));
+}
+
+/// <summary>
+/// Opens one BLOB value for streaming reads (and writes, if writable)
+/// without loading it into memory; see BlobStream.  Check isOpen().
+/// </summary>
+/// <param name="table">The table.</param>
+/// <param name="column">The BLOB column.</param>
+/// <param name="rowid">The row.</param>
+/// <param name="writable">Open for writing as well.</param>
+/// <returns>The stream, positioned at the start.</returns>
+gamzia::BlobStream gamzia::Cursor::openBlob(std::string table, std::string column, int64_t rowid, bool writable)
+{
+   return (BlobStream(mydb, table, column, rowid, writable));
+}
+
+/// <summary>
+/// Helper method to perform a vacuum (compacts the database reclaiming free space).
+/// </summary>
+/// <returns></returns>
+bool gamzia::Cursor::vacuum()
+{
+   return(execute("VACUUM;"));
+}
+
+/// <summary>
+/// Returns up to pages free pages to the file system (all of them if 0),
+/// in a short write transaction.  Needs auto_vacuum=INCREMENTAL, see
+/// Sqlite::setAutoVacuum(); otherwise it does nothing.
+/// </summary>
+/// <param name="pages">Upper bound on pages freed; 0 for all.</param>
+/// <returns>True on success.</returns>
+bool gamzia::Cursor::incrementalVacuum(int pages)
+{
+   // The pragma frees one page per step
+   return (runToEnd("PRAGMA incremental_vacuum(" + std::to_string(std::max(pages, 0)) + ")"));
+}
+
+/// <summary>
+/// PRAGMA optimize: refreshes the query planner's statistics for the tables
+/// and indexes that appear to need it.  Cheap, usually does nothing; meant
+/// to be run now and then, ie, before closing a long lived connection.
+/// </summary>
+/// <returns>True on success.</returns>
+bool gamzia::Cursor::optimize()
+{
+   return (runToEnd("PRAGMA optimize;"));
+}
+
+/// <summary>
+/// ANALYZE: gathers statistics for every table and index.  Reads the whole
+/// database; prefer optimize() for routine use.
+/// </summary>
+/// <returns>True on success.</returns>
+bool gamzia::Cursor::analyze()
+{
+   return (execute("ANALYZE;"));
+}
+
+/// <summary>
+/// Steps sql until it is done, discarding any rows; for pragmas that do
+/// their work a row (or a step) at a time.
+/// </summary>
+/// <returns>True if it ran to the end.</returns>
+bool gamzia::Cursor::runToEnd(const std::string& sql)
+{
+   int rc;
+
+   if (!prepare(sql))
+      return false;
+   do
+      rc = stepStatement();
+   while (rc == SQLITE_ROW);
+   sqlite3_reset(statement);
+   return (rc == SQLITE_DONE);
+}
+
+/// <summary>
+/// Executes a query.  See the params version for information
+/// on how command vs query queries are handled.
+/// </summary>
+/// <param name="sql">The SQL command to execute.</param>
+/// <returns>True if success, false otherwise.</returns>
+bool gamzia::Cursor::execute(std::string sql)
+{
+   if (!prepare(sql))
+      return false;
+
+   return (run());
+}
+
+/// <summary>
+/// Prepares the SQL (or reuses it from the statement cache) and binds params
+/// to its '?' placeholders, in order, as text.  Values are never spliced into
+/// the SQL, so no quoting or sanitizing is needed - or done.
+/// Commands (INSERT, UPDATE, DELETE, ...) run immediately; queries that
+/// return rows are left ready for fetchOne() / fetchAll().
+/// NOTE: Placeholders can only stand for values, not table or column names.
+/// </summary>
+/// <param name="sql">An SQL query with ? placeholders.</param>
+/// <param name="params">A vector of params.  Must have enough params to replace all '?'s.</param>
+/// <returns>True if the statement was prepared (and, for commands, ran), false otherwise.</returns>
+bool gamzia::Cursor::execute(std::string sql, const std::vector<std::string> params)
+{
+   int numParams;
+
+   if (!prepare(sql))
+      return false;
+
+   // Sanity
+   numParams = sqlite3_bind_parameter_count(statement);
+   if ((int)params.size() < numParams)
+   {
+      releaseStatement();
+      return false;
+   }
+
+   // Bind
+   for (int i = 0; i < numParams; i++)
+   {
+      if (sqlite3_bind_text(statement, i + 1, params[i].c_str(), (int)params[i].size(),
+         SQLITE_TRANSIENT) != SQLITE_OK)
+      {
+         releaseStatement();
+         return false;
+      }
+   }
+
+   return (run());
+}
+
+/// <summary>
+/// Bulk execute: runs sql once for every row of params, on one reused
+/// prepared statement, inside transactions of options.batchSize rows.
+/// With options.rowsPerStatement above 1, an "INSERT ... VALUES (?, ?)"
+/// is expanded to that many VALUES groups, so each step inserts several
+/// rows (capped by SQLite's host parameter limit; leftover rows use the
+/// single row form).  SQL without a single, plain '?' VALUES group is
+/// run one row at a time.
+/// If a transaction is already open, the rows join it and the caller
+/// commits; otherwise on failure the current batch is rolled back (earlier
+/// batches stay committed) and false is returned.
+/// NOTE: rows must outlive the call; values are bound without copying.
+/// </summary>
+/// <param name="sql">A command with ? placeholders, ie: an INSERT.</param>
+/// <param name="rows">One vector of params per execution.</param>
+/// <param name="options">Transaction and statement batching.</param>
+/// <returns>True if every row was executed and committed.</returns>
+bool gamzia::Cursor::executeMany(std::string sql, const std::vector<std::vector<std::string>>& rows,
+   ExecuteManyOptions options)
+{
+   std::string multiSql;
+   size_t perStatement = 1;
+   size_t done = 0;
+   size_t inBatch = 0;
+   bool ownTransaction;
+   bool ok;
+   int perRow;
+
+   // Sanity
+   if (mydb == nullptr || !prepare(sql))
+      return false;
+   if (rows.empty())
+      return true;
+   perRow = sqlite3_bind_parameter_count(statement);
+
+   // Multi-row VALUES, within the host parameter limit
+   if (options.rowsPerStatement > 1 && perRow > 0)
+   {
+      perStatement = (size_t)sqlite3_limit(mydb, SQLITE_LIMIT_VARIABLE_NUMBER, -1) / perRow;
+      perStatement = std::min(perStatement, std::min(options.rowsPerStatement, rows.size()));
+      if (perStatement > 1)
+         multiSql = expandValues(sql, perStatement);
+      if (multiSql.empty())
+         perStatement = 1;
+   }
+
+   // Join the caller's transaction if there is one; otherwise run our own
+   ownTransaction = (sqlite3_get_autocommit(mydb) != 0);
+   if (ownTransaction && sqlite3_exec(mydb, "BEGIN", NULL, NULL, NULL) != SQLITE_OK)
+   {
+      releaseStatement();
+      return false;
+   }
+
+   ok = true;
+   if (perStatement > 1)
+      ok = prepare(multiSql) && stepMany(rows, done, perStatement, options.batchSize, ownTransaction, inBatch);
+   if (ok && done < rows.size())
+      ok = prepare(sql) && stepMany(rows, done, 1, options.batchSize, ownTransaction, inBatch);
+   releaseStatement();
+
+   if (!ownTransaction)
+      return ok;
+   if (ok && sqlite3_exec(mydb, "COMMIT", NULL, NULL, NULL) == SQLITE_OK)
+   {
+      deliverChanges();
+      return true;
+   }
+   sqlite3_exec(mydb, "ROLLBACK", NULL, NULL, NULL);
+   return false;
+}
+
+/// <summary>
+/// Binds count values of row to the current statement, starting after
+/// parameter first.  SQLITE_STATIC: the caller's strings outlive the step,
+/// and the cache clears bindings when the statement is handed back.
+/// </summary>
+/// <returns>False if the row is short or a bind fails.</returns>
+bool gamzia::Cursor::bindRow(const std::vector<std::string>& row, int first, int count)
+{
+   if ((int)row.size() < count)
+      return false;
+
+   for (int i = 0; i < count; i++)
+   {
+      if (sqlite3_bind_text(statement, first + i + 1, row[i].c_str(), (int)row[i].size(),
+         SQLITE_STATIC) != SQLITE_OK)
+         return false;
+   }
+   return true;
+}
+
+/// <summary>
+/// executeMany() worker: steps the current statement perStatement rows at a
+/// time for as long as that many rows remain, committing every batchSize
+/// rows when it owns the transaction.
+/// </summary>
+/// <returns>False on the first failing row.</returns>
+bool gamzia::Cursor::stepMany(const std::vector<std::vector<std::string>>& rows, size_t& done,
+   size_t perStatement, size_t batchSize, bool ownTransaction, size_t& inBatch)
+{
+   int perRow = sqlite3_bind_parameter_count(statement) / (int)perStatement;
+   int rc;
+
+   while (rows.size() - done >= perStatement)
+   {
+      for (size_t i = 0; i < perStatement; i++)
+      {
+         if (!bindRow(rows[done + i], (int)i * perRow, perRow))
+            return false;
+      }
+
+      rc = stepStatement();
+      sqlite3_reset(statement);
+      if (rc != SQLITE_DONE && rc != SQLITE_ROW)
+         return false;
+
+      done += perStatement;
+      inBatch += perStatement;
+      if (ownTransaction && batchSize > 0 && inBatch >= batchSize)
+      {
+         if (sqlite3_exec(mydb, "COMMIT", NULL, NULL, NULL) != SQLITE_OK)
+            return false;
+         deliverChanges();
+         if (sqlite3_exec(mydb, "BEGIN", NULL, NULL, NULL) != SQLITE_OK)
+            return false;
+         inBatch = 0;
+      }
+   }
+   return true;
+}
+
+/// <summary>
+/// Repeats the VALUES (...) group of an INSERT groups times:
+/// "INSERT INTO t VALUES (?, ?)" becomes "... VALUES (?, ?), (?, ?), ...".
+/// </summary>
+/// <returns>The expanded SQL; empty if there is no single, plain '?' group.</returns>
+std::string gamzia::Cursor::expandValues(const std::string& sql, size_t groups)
+{
+   std::string upper = sql;
+   std::string group;
+   std::string expanded;
+   size_t pos, open, close, next;
+   bool quoted = false;
+   int depth = 0;
+
+   // The VALUES keyword, as a whole word
+   for (char& c : upper)
+      c = (char)toupper((unsigned char)c);
+   pos = upper.rfind("VALUES");
+   if (pos == std::string::npos || (pos > 0 && (isalnum((unsigned char)upper[pos - 1]) || upper[pos - 1] == '_')))
+      return "";
+   open = sql.find_first_not_of(" \t\r\n", pos + 6);
+   if (open == std::string::npos || sql[open] != '(')
+      return "";
+
+   // Its matching parenthesis
+   close = std::string::npos;
+   for (size_t i = open; i < sql.size() && close == std::string::npos; i++)
+   {
+      if (sql[i] == '\'')
+         quoted = !quoted;
+      else if (!quoted && sql[i] == '(')
+         depth++;
+      else if (!quoted && sql[i] == ')' && --depth == 0)
+         close = i;
+   }
+   if (close == std::string::npos)
+      return "";
+
+   // Numbered or named parameters would repeat, and a second group is
+   // already a multi-row insert
+   group = sql.substr(open, close - open + 1);
+   if (group.find_first_of(":@$") != std::string::npos)
+      return "";
+   for (size_t i = 0; i + 1 < group.size(); i++)
+   {
+      if (group[i] == '?' && isdigit((unsigned char)group[i + 1]))
+         return "";
+   }
+   next = sql.find_first_not_of(" \t\r\n", close + 1);
+   if (next != std::string::npos && sql[next] == ',')
+      return "";
+
+   expanded.reserve(sql.size() + (group.size() + 2) * groups);
+   expanded = sql.substr(0, close + 1);
+   for (size_t i = 1; i < groups; i++)
+   {
+      expanded += ", ";
+      expanded += group;
+   }
+   expanded += sql.substr(close + 1);
+   return (expanded);
+}
+
+/// <summary>
+/// If available, fetches a row of data as a vector of string.  This version
+/// does not return a map, so no column names are available.
+/// </summary>
+/// <returns>A vector representing a row of data.</returns>
+std::vector<std::string> gamzia::Cursor::fetchOne()
+{
+   std::vector<std::string> row;
+
+   // Sanity
+   if (statement == nullptr)
+      return (row);
+
+   int rc = stepStatement();
+   if (rc == SQLITE_ROW)
+   {
+      // NULL values come back as empty strings
+      Row current = Row(statement);
+      int columns = current.getColumnCount();
+      row.reserve(columns);
+      for (int i= 0; i<columns; i++)
+         row.push_back(current.getString(i));
+   }
+   else
+   {
+      // No data. Send empty row back.
+      row.clear();
+   }
+
+   return (row);
+}
+
+/// <summary>
+/// Returns all records read in a single vector of string.  If the vector
+/// has multiple rows, it will continue to place it in the vector.
+/// So, field 1 in a 4 field table would be at index 0, 4, 8, 12 etc...
+/// Column IDs are included as the first row.
+/// </summary>
+/// <returns>The entire table as a vector of string.</returns>
+std::vector<std::string> gamzia::Cursor::fetchAll()
+{
+   std::vector<std::string> table;
+   std::string name;
+
+   table.clear();
+
+   // Sanity
+   if (statement == nullptr)
+      return (table);
+
+   int rc = stepStatement();
+   if (rc == SQLITE_ROW)
+   {
+      // Get column IDs, but just once
+      int columns = sqlite3_column_count(statement);
+      for (int i = 0; i < columns; i++)
+      {
+         name = std::string(sqlite3_column_name(statement, i));
+         table.push_back(name);
+      }
+   }
+
+   while (rc == SQLITE_ROW)
+   {
+      // NULL values come back as empty strings
+      Row current = Row(statement);
+      int columns = current.getColumnCount();
+      for (int i = 0; i < columns; i++)
+         table.push_back(current.getString(i));
+
+      rc = stepStatement();
+   }
+
+   return (table);
+}
+
+/// <summary>
+/// Returns all remaining rows as a column-major ResultSet: typed numeric
+/// columns, one arena for text and blobs, and explicit row / column counts.
+/// Prefer this over fetchAll() for large results.
+/// </summary>
+/// <returns>The rows read; empty (with column names) if none.</returns>
+gamzia::ResultSet gamzia::Cursor::fetchResultSet()
+{
+   ResultSet result;
+   std::chrono::steady_clock::time_point start;
+
+   if (myprofiler)
+      start = std::chrono::steady_clock::now();
+   result.load(statement);
+   if (myprofiler && statement != nullptr)
+   {
+      mystepnanos += (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+         std::chrono::steady_clock::now() - start).count();
+      myrows += result.getRowCount();
+   }
+   return (result);
+}
+
+/// <summary>
+/// Advances to the next row, for use with getRow().
+/// </summary>
+/// <returns>True if positioned on a row; false at the end (or on error).</returns>
+bool gamzia::Cursor::step()
+{
+   if (statement == nullptr)
+      return false;
+   return (stepStatement() == SQLITE_ROW);
+}
+
+/// <summary>
+/// sqlite3_step, timed and counted when a profiler is attached.
+/// </summary>
+int gamzia::Cursor::stepStatement()
+{
+   int rc;
+
+   if (!myprofiler)
+      rc = sqlite3_step(statement);
+   else
+   {
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      rc = sqlite3_step(statement);
+      mystepnanos += (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+         std::chrono::steady_clock::now() - start).count();
+      if (rc == SQLITE_ROW)
+         myrows++;
+   }
+
+   deliverChanges();
+   return (rc);
+}
+
+/// <summary>
+/// Hands a just committed transaction's changes to the change feed's
+/// listeners, if there is a feed and a COMMIT ran.
+/// </summary>
+void gamzia::Cursor::deliverChanges()
+{
+   if (myfeed && myfeed->isCommitting())
+      myfeed->deliver();
+}
+
+/// <summary>
+/// Hands the finished execution of the current statement to the profiler,
+/// before the statement is reset or released.
+/// </summary>
+void gamzia::Cursor::endProfile()
+{
+   if (myprofiler && statement != nullptr)
+      myprofiler->record(mysql, myprepnanos / 1000, mystepnanos / 1000, myrows, statement);
+   myprepnanos = 0;
+   mystepnanos = 0;
+   myrows = 0;
+}
+
+/// <summary>
+/// Returns a view of the current row (after step() returned true).
+/// </summary>
+gamzia::Row gamzia::Cursor::getRow()
+{
+   return (Row(statement));
+}
+
+/// <summary>
+/// Executes a query and returns its rows as a lazily stepped range:
+/// for (gamzia::Row row : k.query(sql, params)) { ... }
+/// On error the range is empty; see isValid().
+/// </summary>
+/// <param name="sql">The SQL to run; may contain '?' parameters.</param>
+/// <param name="params">Values for the parameters, in order.</param>
+/// <returns>A single pass range of Row.</returns>
+gamzia::Query gamzia::Cursor::query(std::string sql, const std::vector<std::string> params)
+{
+   if (!execute(sql, params))
+      return (Query(nullptr));
+   return (Query(this));
+}
+
+/// <summary>
+/// Keyset pagination: returns up to limit rows with key greater than after,
+/// in key order.  Pass an empty after for the first page, then the key of
+/// the last row seen for each following page.  Unlike OFFSET, every page
+/// is a single index seek regardless of how deep into the table it is.
+/// Table, column and key names are pasted into the SQL; never pass user
+/// input for them.
+/// </summary>
+/// <param name="table">The table to read.</param>
+/// <param name="columns">The column list to select, ie: "id, user".</param>
+/// <param name="key">A unique, indexed column to page on.</param>
+/// <param name="after">Last key of the previous page; empty for the first.</param>
+/// <param name="limit">Maximum rows per page.</param>
+/// <returns>A single pass range of Row.</returns>
+gamzia::Query gamzia::Cursor::queryPage(std::string table, std::string columns,
+   std::string key, std::string after, int limit)
+{
+   std::string sql;
+   std::vector<std::string> params;
+
+   // Two fixed SQL texts, so both stay in the statement cache
+   sql = "SELECT " + columns + " FROM " + table;
+   if (!after.empty())
+   {
+      sql += " WHERE " + key + " > ?";
+      params.push_back(after);
+   }
+   sql += " ORDER BY " + key + " LIMIT ?";
+   params.push_back(std::to_string(limit));
+   return (query(sql, params));
+}
+
+/// <summary>
+/// Returns the column names in a vector of string.
+/// </summary>
+/// <returns></returns>
+std::vector<std::string> gamzia::Cursor::getColumnNames()
+{
+   std::vector<std::string> names;
+
+   // Sanity
+   if (statement == nullptr)
+      return (names);
+
+   // Column names come from the prepared statement; no stepping needed,
+   // so the row position for fetchOne() is unaffected.
+   int columns = sqlite3_column_count(statement);
+   for (int i = 0; i < columns; i++)
+   {
+      const char* columnName = sqlite3_column_name(statement, i);
+      names.push_back(std::string(columnName));
+   }
+
+   return(names);
+}
+
+/************************
+*  Class QueryIterator  *
+************************/
+
+gamzia::QueryIterator::QueryIterator()
+{
+   mycursor = nullptr;
+}
+
+gamzia::QueryIterator::QueryIterator(Cursor* cursor)
+{
+   mycursor = cursor;
+   advance();
+}
+
+gamzia::Row gamzia::QueryIterator::operator*() const
+{
+   return (mycursor->getRow());
+}
+
+gamzia::QueryIterator& gamzia::QueryIterator::operator++()
+{
+   advance();
+   return (*this);
+}
+
+void gamzia::QueryIterator::operator++(int)
+{
+   advance();
+}
+
+bool gamzia::QueryIterator::operator==(const QueryIterator& other) const
+{
+   return (mycursor == other.mycursor);
+}
+
+/// <summary>
+/// Steps to the next row; becomes the end iterator when there are no more
+/// (or on error).
+/// </summary>
+void gamzia::QueryIterator::advance()
+{
+   if (mycursor != nullptr && !mycursor->step())
+      mycursor = nullptr;
+}
+
+/****************
+*  Class Query  *
+****************/
+
+gamzia::Query::Query(Cursor* cursor)
+{
+   mycursor = cursor;
+}
+
+gamzia::QueryIterator gamzia::Query::begin()
+{
+   return (QueryIterator(mycursor));
+}
+
+gamzia::QueryIterator gamzia::Query::end()
+{
+   return (QueryIterator());
+}
+
+/// <summary>
+/// False if the query failed to prepare or bind.
+/// </summary>
+bool gamzia::Query::isValid() const
+{
+   return (mycursor != nullptr);
+}
+
+/**************
+*  Class Row  *
+**************/
+
+gamzia::Row::Row(sqlite3_stmt* statement)
+{
+   this->statement = statement;
+}
+
+int gamzia::Row::getColumnCount() const
+{
+   return (sqlite3_column_count(statement));
+}
+
+std::string gamzia::Row::getColumnName(int column) const
+{
+   const char* name = sqlite3_column_name(statement, column);
+   return (name == nullptr ? "" : std::string(name));
+}
+
+/// <summary>
+/// Returns the storage class of the value: SQLITE_INTEGER, SQLITE_FLOAT,
+/// SQLITE_TEXT, SQLITE_BLOB or SQLITE_NULL.
+/// </summary>
+int gamzia::Row::getType(int column) const
+{
+   return (sqlite3_column_type(statement, column));
+}
+
+bool gamzia::Row::isNull(int column) const
+{
+   return (sqlite3_column_type(statement, column) == SQLITE_NULL);
+}
+
+int64_t gamzia::Row::getInt64(int column) const
+{
+   return (sqlite3_column_int64(statement, column));
+}
+
+double gamzia::Row::getDouble(int column) const
+{
+   return (sqlite3_column_double(statement, column));
+}
+
+/// <summary>
+/// Returns the value as text, without copying.  Valid until the next step.
+/// </summary>
+std::string_view gamzia::Row::getText(int column) const
+{
+   // Text first, then bytes: the byte count must describe the text form
+   const unsigned char* text = sqlite3_column_text(statement, column);
+   if (text == nullptr)
+      return std::string_view();
+   return std::string_view((const char*)text, (size_t)sqlite3_column_bytes(statement, column));
+}
+
+/// <summary>
+/// Returns the value as raw bytes, without copying.  Valid until the next step.
+/// </summary>
+std::span<const std::byte> gamzia::Row::getBlob(int column) const
+{
+   const void* blob = sqlite3_column_blob(statement, column);
+   if (blob == nullptr)
+      return std::span<const std::byte>();
+   return std::span<const std::byte>((const std::byte*)blob, (size_t)sqlite3_column_bytes(statement, column));
+}
+
+/// <summary>
+/// Returns a copy of the value as text; NULL becomes an empty string.
+/// </summary>
+std::string gamzia::Row::getString(int column) const
+{
+   return std::string(getText(column));
+}
+
+/// <summary>
+/// Measures Cursor::executeMany() on this machine and disk: once per batch
+/// size, inserts the same rows (three columns, shaped like the accounts
+/// table that AccountManager::addUsers() fills) into a scratch table of
+/// dbname, and reports rows per second.
+/// Small batches pay one COMMIT (an fsync, on a file) per batch; the curve
+/// shows where larger batches stop paying off.  The scratch table is
+/// dropped afterwards.
+/// </summary>
+/// <param name="dbname">The database to measure; a file, for real commit costs.</param>
+/// <param name="batchSizes">ExecuteManyOptions::batchSize values to try.</param>
+/// <param name="rows">Rows inserted per case.</param>
+/// <param name="rowsPerStatement">ExecuteManyOptions::rowsPerStatement.</param>
+/// <returns>One result per batch size; empty if the database can not be used.</returns>
+std::vector<gamzia::ExecuteManyBenchResult> gamzia::executeManyBenchmark(std::string dbname,
+   const std::vector<size_t>& batchSizes, size_t rows, size_t rowsPerStatement)
+{
+   std::vector<ExecuteManyBenchResult> results;
+   std::vector<std::vector<std::string>> data;
+   ExecuteManyOptions options;
+   const std::string table = "executemany_bench";
+
+   Sqlite db = Sqlite(dbname);
+   if (!db.connect())
+      return (results);
+
+   data.reserve(rows);
+   for (size_t i = 0; i < rows; i++)
+      data.push_back({ "user" + std::to_string(i), std::string(64, 'f'), std::to_string(i) });
+
+   options.rowsPerStatement = std::max(rowsPerStatement, (size_t)1);
+   for (size_t batchSize : batchSizes)
+   {
+      gamzia::Cursor k = db.getCursor();
+      if (!k.execute("DROP TABLE IF EXISTS " + table) ||
+         !k.execute("CREATE TABLE " + table + " (user TEXT UNIQUE, password, created)"))
+         break;
+
+      options.batchSize = batchSize;
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      if (!k.executeMany("INSERT INTO " + table + " (user, password, created) VALUES (?, ?, ?)", data, options))
+         break;
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      results.push_back({ batchSize, options.rowsPerStatement, rows,
+         seconds > 0 ? (double)rows / seconds : 0.0 });
+   }
+
+   gamzia::Cursor k = db.getCursor();
+   k.execute("DROP TABLE IF EXISTS " + table);
+   return (results);
+}
+
+/// <summary>
+/// Statement ownership under stress: repeated, moved and detached execute()
+/// calls, with more distinct SQL than the cache holds.  Once every cursor
+/// is gone, the statements still alive on the connection must be exactly
+/// the ones in the statement cache; one more is a leak, one less a double
+/// release.
+/// </summary>
+/// <returns>True if all tests pass.</returns>
+bool doSqliteUnitTests()
+{
+   const size_t capacity = 4;
+   bool ok = true;
+
+   gamzia::Sqlite db = gamzia::Sqlite(":memory:");
+   if (!db.connect())
+      return false;
+   db.setStatementCacheSize(capacity);
+   {
+      gamzia::Cursor k = db.getCursor();
+      if (!k.execute("CREATE TABLE numbers (n INTEGER)") ||
+         !k.executeMany("INSERT INTO numbers VALUES (?)", { { "1" }, { "2" }, { "3" } }))
+         return false;
+   }
+
+   for (int i = 0; i < 50; i++)
+   {
+      std::string sql = "SELECT n FROM numbers WHERE n > " + std::to_string(i % (capacity * 2));
+
+      // Repeated: same SQL, new SQL, and a statement left mid-step
+      gamzia::Cursor k = db.getCursor();
+      ok = k.execute(sql) && ok;
+      ok = k.execute(sql) && ok;
+      ok = k.execute("SELECT count(*) FROM numbers") && ok;
+      k.fetchOne();
+      ok = k.execute(sql) && ok;
+      k.fetchOne();
+
+      // Two cursors on the same SQL at once; one statement is left over
+      gamzia::Cursor twin = db.getCursor();
+      ok = twin.execute(sql) && ok;
+
+      // Moved: the source is detached, the target drops what it owned
+      gamzia::Cursor moved = std::move(k);
+      ok = !k.isValid() && !k.execute(sql) && ok;
+      ok = moved.execute(sql) && ok;
+      twin = std::move(moved);
+      ok = !moved.isValid() && twin.isValid() && ok;
+      twin.fetchOne();
+
+      // Detached
+      gamzia::Cursor detached = gamzia::Cursor();
+      ok = !detached.execute(sql) && !detached.step() && detached.fetchOne().empty() && ok;
+   }
+
+   size_t live = 0;
+   for (sqlite3_stmt* statement = sqlite3_next_stmt(db.getHandle(), nullptr); statement != nullptr;
+      statement = sqlite3_next_stmt(db.getHandle(), statement))
+      live++;
+
+   gamzia::StatementCacheStats stats = db.getStatementCacheStats();
+   return (ok && stats.size > 0 && stats.size <= capacity && live == stats.size);
+}
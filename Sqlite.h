@@ -1,56 +1,559 @@
-#pragma once
-#include <string>
-#include <ostream>
-#include "sqlite3.h"
-#include <map>
-#include <string>
-#include <vector>
-
-// Forward declaration
-class Sqlite;
-class Cursor;
-
-namespace gamzia
-{
-   class Cursor
-   {
-
-   public:
-      Cursor(sqlite3 *db);
-      ~Cursor();
-      bool execute(std::string sql);
-      bool execute(std::string sql, const std::vector<std::string> params);
-      std::vector<std::string> fetchOne();
-      std::vector<std::string> fetchAll();
-      std::vector<std::string> getColumnNames();
-      bool doesTableExist(std::string table);
-      bool commit();
-      bool rollback();
-      bool vacuum();
-
-   private:
-      sqlite3      *mydb;
-      sqlite3_stmt *statement;
-   };
-
-   class Sqlite
-   {
-
-   public:
-      Sqlite();
-      Sqlite(std::string dbname);
-      ~Sqlite();
-      bool connect();
-      void close();
-      std::string getLastError();
-      Cursor getCursor();
-   
-   private:
-      std::string mydbname;
-      sqlite3     *mydb;
-      bool        isConnected;
-      std::string myerror;
-   }; // class
-
-}; // Namespace
-
+#pragma once
+#include <string>
+#include <ostream>
+#include "sqlite3.h"
+#include <map>
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <string_view>
+#include <span>
+#include <tuple>
+#include <optional>
+#include <utility>
+#include <cstdint>
+#include <type_traits>
+#include <iterator>
+#include <cstddef>
+#include <functional>
+#include <exception>
+#include "ResultSet.h"
+#include "QueryProfiler.h"
+#include "ChangeFeed.h"
+#include "BlobStream.h"
+
+// Forward declaration
+class Sqlite;
+class Cursor;
+
+namespace gamzia
+{
+   struct StatementCacheStats
+   {
+      unsigned long long hits;
+      unsigned long long misses;
+      unsigned long long evictions;
+      size_t size;
+      size_t capacity;
+   };
+
+   /// <summary>
+   /// Options for Cursor::executeMany().
+   /// batchSize: rows per transaction (COMMIT every N rows); 0 for a single
+   /// transaction.  rowsPerStatement: when above 1, an INSERT ... VALUES (...)
+   /// is expanded to that many VALUES groups per statement.
+   /// </summary>
+   struct ExecuteManyOptions
+   {
+      size_t batchSize = 10000;
+      size_t rowsPerStatement = 1;
+   };
+
+   /// <summary>
+   /// One case of executeManyBenchmark(): insert throughput at a batch size.
+   /// </summary>
+   struct ExecuteManyBenchResult
+   {
+      size_t batchSize;
+      size_t rowsPerStatement;
+      size_t rows;
+      double rowsPerSecond;
+   };
+
+   class StatementCache
+   {
+
+   public:
+      StatementCache(sqlite3 *db, size_t capacity);
+      ~StatementCache();
+      sqlite3_stmt* acquire(const std::string& sql);
+      void release(const std::string& sql, sqlite3_stmt* statement);
+      void setCapacity(size_t capacity);
+      StatementCacheStats getStats();
+      void close();
+
+   private:
+      typedef std::list<std::pair<std::string, sqlite3_stmt*>> LruList;
+
+      sqlite3     *mydb;
+      size_t      mycapacity;
+      bool        isClosed;
+      LruList     mylru;
+      std::unordered_map<std::string, LruList::iterator> myindex;
+      StatementCacheStats mystats;
+
+      void trim();
+   };
+
+   template <typename T> struct isOptional : std::false_type {};
+   template <typename T> struct isOptional<std::optional<T>> : std::true_type {};
+
+   /*
+   * A view of the row a cursor is currently positioned on.  Nothing is
+   * converted or copied unless asked for: getText() and getBlob() point
+   * straight into SQLite's buffers and are only valid until the cursor
+   * steps again (or executes something else).
+   */
+   class Row
+   {
+
+   public:
+      Row(sqlite3_stmt *statement);
+      int getColumnCount() const;
+      std::string getColumnName(int column) const;
+      int getType(int column) const;
+      bool isNull(int column) const;
+      int64_t getInt64(int column) const;
+      double getDouble(int column) const;
+      std::string_view getText(int column) const;
+      std::span<const std::byte> getBlob(int column) const;
+      std::string getString(int column) const;
+
+      /// <summary>
+      /// Typed access: int64_t (or any integer type), double, bool,
+      /// std::string, std::string_view, std::span of const std::byte,
+      /// or std::optional of any of those (nullopt for NULL).
+      /// </summary>
+      template <typename T>
+      T get(int column) const
+      {
+         if constexpr (isOptional<T>::value)
+         {
+            if (isNull(column))
+               return T();
+            return T(get<typename T::value_type>(column));
+         }
+         else if constexpr (std::is_same_v<T, std::string_view>)
+            return getText(column);
+         else if constexpr (std::is_same_v<T, std::string>)
+            return getString(column);
+         else if constexpr (std::is_same_v<T, std::span<const std::byte>>)
+            return getBlob(column);
+         else if constexpr (std::is_same_v<T, bool>)
+            return getInt64(column) != 0;
+         else if constexpr (std::is_integral_v<T>)
+            return (T)getInt64(column);
+         else if constexpr (std::is_floating_point_v<T>)
+            return (T)getDouble(column);
+         else
+            static_assert(!sizeof(T), "Row::get: unsupported column type");
+      }
+
+      /// <summary>
+      /// Decodes the first N columns into a tuple of N types.
+      /// </summary>
+      template <typename Tuple>
+      Tuple as() const
+      {
+         return asTuple<Tuple>(std::make_index_sequence<std::tuple_size_v<Tuple>>{});
+      }
+
+   private:
+      sqlite3_stmt *statement;
+
+      template <typename Tuple, size_t... I>
+      Tuple asTuple(std::index_sequence<I...>) const
+      {
+         return Tuple(get<std::tuple_element_t<I, Tuple>>((int)I)...);
+      }
+   };
+
+   class Cursor;
+
+   /// <summary>
+   /// Single pass input iterator over a cursor's rows.  Each increment is
+   /// one Cursor::step(); the Row it yields is valid until the next increment.
+   /// </summary>
+   class QueryIterator
+   {
+
+   public:
+      typedef std::input_iterator_tag iterator_category;
+      typedef Row value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef Row reference;
+
+      QueryIterator();
+      QueryIterator(Cursor *cursor);
+      Row operator*() const;
+      QueryIterator& operator++();
+      void operator++(int);
+      bool operator==(const QueryIterator& other) const;
+
+   private:
+      Cursor *mycursor;
+
+      void advance();
+   };
+
+   /// <summary>
+   /// The range returned by Cursor::query().  Rows are stepped lazily as the
+   /// loop advances, so nothing is materialized.  Single pass: begin() starts
+   /// stepping, and the owning Cursor must outlive the loop.
+   /// </summary>
+   class Query
+   {
+
+   public:
+      Query(Cursor *cursor);
+      QueryIterator begin();
+      QueryIterator end();
+      bool isValid() const;
+
+   private:
+      Cursor *mycursor;
+   };
+
+   class Cursor
+   {
+
+   public:
+      Cursor();
+      explicit Cursor(sqlite3 *db, std::shared_ptr<StatementCache> cache = nullptr,
+         std::shared_ptr<QueryProfiler> profiler = nullptr, std::shared_ptr<ChangeFeed> feed = nullptr);
+      ~Cursor();
+      Cursor(const Cursor&) = delete;
+      Cursor& operator=(const Cursor&) = delete;
+      Cursor(Cursor&& other) noexcept;
+      Cursor& operator=(Cursor&& other) noexcept;
+      bool isValid() const;
+      bool execute(std::string sql);
+      bool execute(std::string sql, const std::vector<std::string> params);
+      std::vector<std::string> fetchOne();
+      std::vector<std::string> fetchAll();
+      ResultSet fetchResultSet();
+      std::vector<std::string> getColumnNames();
+      bool step();
+      Row getRow();
+      Query query(std::string sql, const std::vector<std::string> params = {});
+      Query queryPage(std::string table, std::string columns, std::string key,
+         std::string after, int limit);
+
+      /// <summary>
+      /// Steps to the next row and decodes it into a tuple, ie:
+      /// fetch&lt;std::tuple&lt;int64_t, std::string_view, double&gt;&gt;().
+      /// Returns nullopt when there are no more rows.
+      /// </summary>
+      template <typename Tuple>
+      std::optional<Tuple> fetch()
+      {
+         if (!step())
+            return std::nullopt;
+         return getRow().as<Tuple>();
+      }
+
+      /// <summary>
+      /// Steps to the next row and constructs T from its columns, decoded
+      /// as the listed types, ie: fetchAs&lt;User, int64_t, std::string&gt;().
+      /// </summary>
+      template <typename T, typename... Columns>
+      std::optional<T> fetchAs()
+      {
+         if (!step())
+            return std::nullopt;
+         return std::make_from_tuple<T>(getRow().as<std::tuple<Columns...>>());
+      }
+
+      bool doesTableExist(std::string table);
+      bool commit();
+      bool rollback();
+      bool vacuum();
+      bool incrementalVacuum(int pages = 0);
+      bool optimize();
+      bool analyze();
+      bool executeMany(std::string sql, const std::vector<std::vector<std::string>>& rows,
+         ExecuteManyOptions options = ExecuteManyOptions());
+      BlobStream openBlob(std::string table, std::string column, int64_t rowid, bool writable = false);
+
+   private:
+      sqlite3      *mydb;
+      sqlite3_stmt *statement;
+      std::string  mysql;
+      std::shared_ptr<StatementCache> mycache;
+      std::shared_ptr<QueryProfiler> myprofiler;
+      std::shared_ptr<ChangeFeed> myfeed;
+      unsigned long long myprepnanos;
+      unsigned long long mystepnanos;
+      unsigned long long myrows;
+
+      bool prepare(const std::string& sql);
+      bool run();
+      bool runToEnd(const std::string& sql);
+      void releaseStatement();
+      int stepStatement();
+      void endProfile();
+      void deliverChanges();
+      bool bindRow(const std::vector<std::string>& row, int first, int count);
+      bool stepMany(const std::vector<std::vector<std::string>>& rows, size_t& done,
+         size_t perStatement, size_t batchSize, bool ownTransaction, size_t& inBatch);
+      static std::string expandValues(const std::string& sql, size_t groups);
+   };
+
+   /// <summary>
+   /// Conversions between sqlite3_value / sqlite3_context and C++ types, for
+   /// functions registered with Sqlite::registerFunction() and
+   /// registerAggregate().  The same types as Row::get() are supported.
+   /// </summary>
+   class SqlValue
+   {
+
+   public:
+      template <typename T>
+      static T get(sqlite3_value *value)
+      {
+         if constexpr (isOptional<T>::value)
+         {
+            if (sqlite3_value_type(value) == SQLITE_NULL)
+               return T();
+            return T(get<typename T::value_type>(value));
+         }
+         else if constexpr (std::is_same_v<T, std::string_view> || std::is_same_v<T, std::string>)
+         {
+            // text() before bytes(), as SQLite requires
+            const char* text = (const char*)sqlite3_value_text(value);
+            return (text == nullptr ? T() : T(text, (size_t)sqlite3_value_bytes(value)));
+         }
+         else if constexpr (std::is_same_v<T, std::span<const std::byte>>)
+         {
+            const std::byte* blob = (const std::byte*)sqlite3_value_blob(value);
+            return (blob == nullptr ? T() : T(blob, (size_t)sqlite3_value_bytes(value)));
+         }
+         else if constexpr (std::is_same_v<T, bool>)
+            return sqlite3_value_int64(value) != 0;
+         else if constexpr (std::is_integral_v<T>)
+            return (T)sqlite3_value_int64(value);
+         else if constexpr (std::is_floating_point_v<T>)
+            return (T)sqlite3_value_double(value);
+         else
+            static_assert(!sizeof(T), "SqlValue::get: unsupported argument type");
+      }
+
+      template <typename T>
+      static void result(sqlite3_context *context, const T& value)
+      {
+         if constexpr (isOptional<T>::value)
+         {
+            if (!value.has_value())
+               sqlite3_result_null(context);
+            else
+               result(context, *value);
+         }
+         else if constexpr (std::is_same_v<T, std::span<const std::byte>>)
+            sqlite3_result_blob64(context, value.data(), value.size(), SQLITE_TRANSIENT);
+         else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+         {
+            std::string_view text = value;
+            sqlite3_result_text64(context, text.data(), text.size(), SQLITE_TRANSIENT, SQLITE_UTF8);
+         }
+         else if constexpr (std::is_integral_v<T>)
+            sqlite3_result_int64(context, (sqlite3_int64)value);
+         else if constexpr (std::is_floating_point_v<T>)
+            sqlite3_result_double(context, (double)value);
+         else
+            static_assert(!sizeof(T), "SqlValue::result: unsupported result type");
+      }
+   };
+
+   class Sqlite
+   {
+
+   public:
+      Sqlite();
+      Sqlite(std::string dbname);
+      ~Sqlite();
+      Sqlite(const Sqlite&) = delete;
+      Sqlite& operator=(const Sqlite&) = delete;
+      Sqlite(Sqlite&& other) noexcept;
+      Sqlite& operator=(Sqlite&& other) noexcept;
+      bool connect();
+      bool connect(int flags);
+      void close();
+      std::string getLastError();
+      Cursor getCursor();
+      sqlite3* getHandle();
+      bool setBusyTimeout(int milliseconds);
+      bool setJournalMode(std::string mode);
+      void setStatementCacheSize(size_t size);
+      StatementCacheStats getStatementCacheStats();
+      void setProfiler(std::shared_ptr<QueryProfiler> profiler);
+      std::shared_ptr<QueryProfiler> getProfiler();
+      bool backup(Sqlite& destination, int pagesPerStep = BACKUP_STEP_PAGES, int sleepMillis = 0);
+      long long getDataVersion();
+      bool setAutoVacuum(std::string mode);
+      long long getFreePages();
+      long long getPageCount();
+      int subscribe(ChangeListener listener, std::string table = "");
+      bool unsubscribe(int id);
+      void flushChanges();
+
+      /// <summary>
+      /// Registers a C++ function (lambda, function pointer, std::function)
+      /// as an SQL scalar function on this connection, ie:
+      /// registerFunction("score", [](int64_t wins, int64_t games) { ... }).
+      /// Arguments and result are converted as in SqlValue; the SQL argument
+      /// count is the function's.  Deterministic functions (same arguments,
+      /// same result) can be used in indexes and are evaluated once per
+      /// statement where possible.  An exception thrown by the function
+      /// fails the statement with its message.
+      /// </summary>
+      template <typename F>
+      bool registerFunction(const std::string& name, F function, bool deterministic = true)
+      {
+         return registerScalar(name, std::function(function), deterministic);
+      }
+
+      /// <summary>
+      /// Registers an SQL aggregate function.  Each group starts from a copy
+      /// of initial; step(State&, args...) is called per row and
+      /// final(State&) returns the result, ie:
+      /// registerAggregate("product", 1.0, [](double& p, double x) { p *= x; },
+      ///    [](double& p) { return p; }).
+      /// </summary>
+      template <typename State, typename Step, typename Final>
+      bool registerAggregate(const std::string& name, State initial, Step step, Final final,
+         bool deterministic = true)
+      {
+         return registerAggregateOf(name, std::move(initial), std::function(step), std::function(final), deterministic);
+      }
+
+      inline static const size_t STATEMENT_CACHE_SIZE = 64;
+      inline static const int BACKUP_STEP_PAGES = 256;
+   
+   private:
+      template <typename State, typename R, typename... Args>
+      struct Aggregate
+      {
+         State initial;
+         std::function<void(State&, Args...)> step;
+         std::function<R(State&)> final;
+      };
+
+      template <typename R, typename... Args>
+      bool registerScalar(const std::string& name, std::function<R(Args...)> function, bool deterministic)
+      {
+         typedef std::function<R(Args...)> Function;
+         if (!isConnected)
+            return false;
+
+         // SQLite owns the copy from here and calls destroy() on it, also on failure
+         Function* data = new Function(std::move(function));
+         return (sqlite3_create_function_v2(mydb, name.c_str(), (int)sizeof...(Args), flagsOf(deterministic),
+            data, &callScalar<R, Args...>, nullptr, nullptr, &destroy<Function>) == SQLITE_OK);
+      }
+
+      template <typename State, typename R, typename... Args>
+      bool registerAggregateOf(const std::string& name, State initial, std::function<void(State&, Args...)> step,
+         std::function<R(State&)> final, bool deterministic)
+      {
+         typedef Aggregate<State, R, Args...> Data;
+         if (!isConnected)
+            return false;
+
+         Data* data = new Data{ std::move(initial), std::move(step), std::move(final) };
+         return (sqlite3_create_function_v2(mydb, name.c_str(), (int)sizeof...(Args), flagsOf(deterministic),
+            data, nullptr, &stepAggregate<State, R, Args...>, &finalAggregate<State, R, Args...>, &destroy<Data>) == SQLITE_OK);
+      }
+
+      template <typename R, typename... Args>
+      static void callScalar(sqlite3_context *context, int, sqlite3_value **argv)
+      {
+         std::function<R(Args...)>& function = *(std::function<R(Args...)>*)sqlite3_user_data(context);
+         guard(context, [&] { callWith<R, Args...>(context, function, argv, std::index_sequence_for<Args...>{}); });
+      }
+
+      template <typename R, typename... Args, size_t... I>
+      static void callWith(sqlite3_context *context, std::function<R(Args...)>& function, sqlite3_value **argv,
+         std::index_sequence<I...>)
+      {
+         SqlValue::result(context, function(SqlValue::get<std::decay_t<Args>>(argv[I])...));
+      }
+
+      template <typename State, typename R, typename... Args>
+      static void stepAggregate(sqlite3_context *context, int, sqlite3_value **argv)
+      {
+         Aggregate<State, R, Args...>& data = *(Aggregate<State, R, Args...>*)sqlite3_user_data(context);
+
+         // The group's state lives behind a pointer in SQLite's per group memory
+         State** slot = (State**)sqlite3_aggregate_context(context, sizeof(State*));
+         if (slot == nullptr)
+         {
+            sqlite3_result_error_nomem(context);
+            return;
+         }
+         guard(context, [&]
+         {
+            if (*slot == nullptr)
+               *slot = new State(data.initial);
+            stepWith<State, R, Args...>(data, **slot, argv, std::index_sequence_for<Args...>{});
+         });
+      }
+
+      template <typename State, typename R, typename... Args, size_t... I>
+      static void stepWith(Aggregate<State, R, Args...>& data, State& state, sqlite3_value **argv,
+         std::index_sequence<I...>)
+      {
+         data.step(state, SqlValue::get<std::decay_t<Args>>(argv[I])...);
+      }
+
+      template <typename State, typename R, typename... Args>
+      static void finalAggregate(sqlite3_context *context)
+      {
+         Aggregate<State, R, Args...>& data = *(Aggregate<State, R, Args...>*)sqlite3_user_data(context);
+
+         // Size 0: null if no row was stepped (an empty group)
+         State** slot = (State**)sqlite3_aggregate_context(context, 0);
+         std::unique_ptr<State> state(slot == nullptr ? nullptr : *slot);
+         if (state == nullptr)
+            state = std::make_unique<State>(data.initial);
+         guard(context, [&] { SqlValue::result(context, data.final(*state)); });
+      }
+
+      template <typename Body>
+      static void guard(sqlite3_context *context, Body body)
+      {
+         // Exceptions must not unwind through SQLite's C frames
+         try
+         {
+            body();
+         }
+         catch (const std::exception& e)
+         {
+            sqlite3_result_error(context, e.what(), -1);
+         }
+         catch (...)
+         {
+            sqlite3_result_error(context, "exception in registered function", -1);
+         }
+      }
+
+      template <typename T>
+      static void destroy(void *data)
+      {
+         delete (T*)data;
+      }
+
+      static int flagsOf(bool deterministic)
+      {
+         return (SQLITE_UTF8 | (deterministic ? SQLITE_DETERMINISTIC : 0));
+      }
+
+      long long pragmaInteger(const char* pragma);
+
+      std::string mydbname;
+      sqlite3     *mydb;
+      bool        isConnected;
+      std::string myerror;
+      size_t      mycachesize;
+      std::shared_ptr<StatementCache> mycache;
+      std::shared_ptr<QueryProfiler> myprofiler;
+      std::shared_ptr<ChangeFeed> myfeed;
+   }; // class
+
+   std::vector<ExecuteManyBenchResult> executeManyBenchmark(std::string dbname, const std::vector<size_t>& batchSizes,
+      size_t rows = 100000, size_t rowsPerStatement = 1);
+
+}; // Namespace
+
+bool doSqliteUnitTests();
@@ -0,0 +1,392 @@
+/*
+* Class WriteQueue
+* ================
+*
+* Serializes writes to a Sqlite database through one writer thread, with
+* group commit.
+*
+* With one transaction per write, every commit() pays its own fsync, and a
+* burst of small writes is limited to a few hundred per second by the disk.
+* Here callers submit write jobs (closures taking the connection) and get a
+* future back.  The writer thread takes whatever has queued (up to maxGroup
+* jobs) and runs it all in a single transaction: one fsync for the whole
+* group.  Jobs submitted while a group is committing form the next group,
+* so groups grow with load by themselves.  The default window is 0, which
+* starts each commit as soon as the writer is free; a window above 0 holds
+* the group open that long for more jobs to join, which only pays off when
+* submitters do not wait on their futures.
+*
+* Each job runs inside its own SAVEPOINT, so a job that returns false (or
+* throws) is rolled back alone without disturbing its neighbours.  A job
+* whose statement ends the whole transaction (INSERT OR ROLLBACK, a full
+* disk, ...) fails along with the jobs before it in the group; the jobs
+* after it start a new transaction.  A job's
+* future resolves only after the group's COMMIT has returned, to true if
+* its work is now durable and to false if it was rolled back.  Durability
+* per write is therefore the same as committing each one; only the latency
+* changes, by at most the window.
+*
+* Jobs must not BEGIN, COMMIT or ROLLBACK themselves (the queue owns the
+* transaction); Cursor::commit() would end the whole group early.
+*
+-->
+gamzia::WriteQueue writes = gamzia::WriteQueue("accounts.db");
+
+std::future<bool> done = writes.submit([=](gamzia::Sqlite& db)
+{
+   gamzia::Cursor k = db.getCursor();
+   return k.execute("UPDATE accounts SET password=? WHERE user=?", { hash, user });
+});
+
+if (done.get())
+   ;  // durable
+<--
+*/
+
+#include "WriteQueue.h"
+#include <algorithm>
+#include <filesystem>
+
+
+/// <summary>
+/// Constructor; the queue opens and owns its own connection to dbname.
+/// </summary>
+/// <param name="dbname">The database file.</param>
+/// <param name="maxGroup">Most jobs per transaction.</param>
+/// <param name="window">Longest a job waits for others to join its group.</param>
+gamzia::WriteQueue::WriteQueue(std::string dbname, size_t maxGroup, std::chrono::microseconds window)
+{
+   mypool = nullptr;
+   mymaxgroup = std::max(maxGroup, (size_t)1);
+   mywindow = window;
+   mystats = WriteQueueStats();
+   isStopping = false;
+
+   mydb = std::make_unique<Sqlite>(dbname);
+   isReadyFlag = mydb->connect() && mydb->setBusyTimeout(ConnectionPool::BUSY_TIMEOUT);
+   if (!isReadyFlag)
+   {
+      myerror = mydb->getLastError();
+      return;
+   }
+   start();
+}
+
+/// <summary>
+/// Constructor; each group leases the pool's writer connection, so other
+/// pool users can still write between groups.
+/// </summary>
+/// <param name="pool">A ready connection pool.</param>
+/// <param name="maxGroup">Most jobs per transaction.</param>
+/// <param name="window">Longest a job waits for others to join its group.</param>
+gamzia::WriteQueue::WriteQueue(ConnectionPool& pool, size_t maxGroup, std::chrono::microseconds window)
+{
+   mypool = &pool;
+   mymaxgroup = std::max(maxGroup, (size_t)1);
+   mywindow = window;
+   mystats = WriteQueueStats();
+   isStopping = false;
+
+   isReadyFlag = pool.isReady();
+   if (!isReadyFlag)
+   {
+      myerror = pool.getLastError();
+      return;
+   }
+   start();
+}
+
+/// <summary>
+/// Commits everything still queued, then stops the writer thread.
+/// </summary>
+gamzia::WriteQueue::~WriteQueue()
+{
+   stop();
+}
+
+bool gamzia::WriteQueue::isReady()
+{
+   return (isReadyFlag);
+}
+
+std::string gamzia::WriteQueue::getLastError()
+{
+   std::lock_guard<std::mutex> guard(mylock);
+   return (myerror);
+}
+
+/// <summary>
+/// Queues a write job.  It runs on the writer thread, inside a savepoint
+/// of the current group's transaction; return false to roll it back.
+/// </summary>
+/// <param name="job">The write, given the writer's connection.</param>
+/// <returns>Resolves to true once the job's work is committed; false if it
+/// was rolled back or the queue is stopped.</returns>
+std::future<bool> gamzia::WriteQueue::submit(Job job)
+{
+   Entry entry;
+   std::future<bool> result = entry.done.get_future();
+   entry.job = std::move(job);
+
+   {
+      std::lock_guard<std::mutex> guard(mylock);
+      if (!isReadyFlag || isStopping)
+      {
+         entry.done.set_value(false);
+         return (result);
+      }
+      myqueue.push_back(std::move(entry));
+      mystats.submitted++;
+   }
+   mywork.notify_one();
+   return (result);
+}
+
+/// <summary>
+/// Stops accepting jobs, commits the ones already queued and joins the
+/// writer thread.  Safe to call more than once.
+/// </summary>
+void gamzia::WriteQueue::stop()
+{
+   {
+      std::lock_guard<std::mutex> guard(mylock);
+      isStopping = true;
+   }
+   mywork.notify_one();
+   if (mywriter.joinable())
+      mywriter.join();
+}
+
+/// <summary>
+/// Returns a snapshot of the counters.  committed / groups is the average
+/// number of writes sharing one fsync.
+/// </summary>
+gamzia::WriteQueueStats gamzia::WriteQueue::getStats()
+{
+   std::lock_guard<std::mutex> guard(mylock);
+   WriteQueueStats stats = mystats;
+   stats.pending = myqueue.size();
+   return (stats);
+}
+
+void gamzia::WriteQueue::start()
+{
+   mywriter = std::thread(&WriteQueue::run, this);
+}
+
+/// <summary>
+/// Writer thread: waits for a first job, lets the group fill for up to the
+/// window (or maxGroup jobs), then commits it.  Drains the queue on stop.
+/// </summary>
+void gamzia::WriteQueue::run()
+{
+   std::vector<Entry> group;
+
+   for (;;)
+   {
+      {
+         std::unique_lock<std::mutex> guard(mylock);
+         mywork.wait(guard, [this] { return isStopping || !myqueue.empty(); });
+         if (myqueue.empty())
+            return;
+
+         // Group commit window, measured from the first job's pickup
+         std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + mywindow;
+         mywork.wait_until(guard, deadline, [this] { return isStopping || myqueue.size() >= mymaxgroup; });
+
+         size_t count = std::min(myqueue.size(), mymaxgroup);
+         group.clear();
+         group.reserve(count);
+         for (size_t i = 0; i < count; i++)
+         {
+            group.push_back(std::move(myqueue.front()));
+            myqueue.pop_front();
+         }
+      }
+
+      commitGroup(group);
+   }
+}
+
+/// <summary>
+/// Runs one group in a single transaction, each job in its own savepoint.
+/// A job that ends the whole transaction (ie, INSERT OR ROLLBACK, or
+/// SQLITE_FULL) takes the jobs before it down too; they are failed, and the
+/// jobs after it run in a new transaction.  Results are only reported once
+/// the transaction holding them has committed.
+/// </summary>
+void gamzia::WriteQueue::commitGroup(std::vector<Entry>& group)
+{
+   std::vector<bool> results(group.size(), false);
+   ConnectionLease lease;
+   Sqlite* db = mydb.get();
+   size_t first = 0;
+   size_t transactions = 0;
+   std::string error;
+
+   if (mypool != nullptr)
+   {
+      lease = mypool->acquireWriter();
+      db = (lease.isValid() ? &lease.get() : nullptr);
+   }
+
+   sqlite3* handle = (db == nullptr ? nullptr : db->getHandle());
+   if (handle == nullptr)
+   {
+      std::lock_guard<std::mutex> guard(mylock);
+      myerror = "writer connection unavailable";
+      finish(group, results, 0);
+      return;
+   }
+
+   while (first < group.size())
+   {
+      size_t end = first;
+      bool isIntact = true;
+
+      transactions++;
+      if (sqlite3_exec(handle, "BEGIN IMMEDIATE", NULL, NULL, NULL) != SQLITE_OK)
+      {
+         // The rest of the group stays failed
+         error = sqlite3_errmsg(handle);
+         break;
+      }
+
+      while (end < group.size() && isIntact)
+      {
+         bool ok = false;
+         isIntact = runJob(handle, *db, group[end], ok);
+         results[end++] = ok;
+      }
+
+      if (isIntact)
+      {
+         // One fsync for the whole group
+         if (sqlite3_exec(handle, "COMMIT", NULL, NULL, NULL) == SQLITE_OK)
+         {
+            db->flushChanges();
+            first = end;
+            continue;
+         }
+      }
+
+      // Nothing from first to end is durable
+      error = sqlite3_errmsg(handle);
+      if (sqlite3_get_autocommit(handle) == 0)
+         sqlite3_exec(handle, "ROLLBACK", NULL, NULL, NULL);
+      for (size_t i = first; i < end; i++)
+         results[i] = false;
+      first = end;
+   }
+
+   std::lock_guard<std::mutex> guard(mylock);
+   if (!error.empty())
+      myerror = error;
+   finish(group, results, transactions);
+}
+
+/// <summary>
+/// Runs one job in a savepoint of the open transaction, rolling it back
+/// alone if it fails.
+/// </summary>
+/// <param name="ok">Receives the job's result.</param>
+/// <returns>False if the transaction can no longer be trusted: a savepoint
+/// statement failed, or the transaction is gone.</returns>
+bool gamzia::WriteQueue::runJob(sqlite3* handle, Sqlite& db, Entry& entry, bool& ok)
+{
+   ok = false;
+   if (sqlite3_exec(handle, "SAVEPOINT writequeue", NULL, NULL, NULL) != SQLITE_OK)
+      return false;
+
+   try
+   {
+      ok = entry.job(db);
+   }
+   catch (...)
+   {
+      ok = false;
+   }
+
+   // A statement that ended the whole transaction took the savepoint with it
+   if (sqlite3_get_autocommit(handle) != 0)
+   {
+      ok = false;
+      return false;
+   }
+
+   if (!ok && sqlite3_exec(handle, "ROLLBACK TO writequeue", NULL, NULL, NULL) != SQLITE_OK)
+      return false;
+   return (sqlite3_exec(handle, "RELEASE writequeue", NULL, NULL, NULL) == SQLITE_OK);
+}
+
+/// <summary>
+/// Resolves the group's futures and updates the counters; mylock held.
+/// </summary>
+/// <param name="results">Per job: true if committed.</param>
+/// <param name="transactions">Transactions the group took.</param>
+void gamzia::WriteQueue::finish(std::vector<Entry>& group, std::vector<bool>& results, size_t transactions)
+{
+   mystats.groups += transactions;
+   mystats.largestGroup = std::max(mystats.largestGroup, group.size());
+   for (size_t i = 0; i < group.size(); i++)
+   {
+      if (results[i])
+         mystats.committed++;
+      else
+         mystats.failed++;
+      group[i].done.set_value(results[i]);
+   }
+}
+
+
+/// <summary>
+/// A job that ends the group's transaction must not lose or misreport its
+/// neighbours: 'a', then an INSERT OR ROLLBACK duplicate of 'a' (which
+/// rolls back the transaction, 'a' with it), then 'c' in the same group.
+/// Expects false, false, true, and only 'c' in the file.
+/// </summary>
+/// <returns>True if the queue behaved.</returns>
+bool doWQUnitTests()
+{
+   const std::string& dbname = gamzia::WriteQueue::TESTDB;
+   std::vector<std::string> row;
+   bool ok;
+
+   std::filesystem::remove(dbname);
+   {
+      gamzia::Sqlite db = gamzia::Sqlite(dbname);
+      if (!db.connect())
+         return false;
+      gamzia::Cursor k = db.getCursor();
+      if (!k.execute("CREATE TABLE names (name TEXT UNIQUE)"))
+         return false;
+   }
+
+   auto insert = [](std::string sql)
+   {
+      return [sql](gamzia::Sqlite& db)
+      {
+         gamzia::Cursor k = db.getCursor();
+         return k.execute(sql);
+      };
+   };
+
+   {
+      // The window puts all three in one group
+      gamzia::WriteQueue writes = gamzia::WriteQueue(dbname, gamzia::WriteQueue::MAX_GROUP, std::chrono::milliseconds(200));
+      std::future<bool> a = writes.submit(insert("INSERT INTO names VALUES ('a')"));
+      std::future<bool> duplicate = writes.submit(insert("INSERT OR ROLLBACK INTO names VALUES ('a')"));
+      std::future<bool> c = writes.submit(insert("INSERT INTO names VALUES ('c')"));
+      ok = (!a.get() && !duplicate.get() && c.get());
+   }
+
+   {
+      gamzia::Sqlite db = gamzia::Sqlite(dbname);
+      db.connect();
+      gamzia::Cursor k = db.getCursor();
+      if (k.execute("SELECT group_concat(name) FROM names"))
+         row = k.fetchOne();
+   }
+   std::filesystem::remove(dbname);
+   return (ok && !row.empty() && row[0] == "c");
+}
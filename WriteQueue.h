@@ -0,0 +1,82 @@
+#pragma once
+#include <string>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "Sqlite.h"
+#include "ConnectionPool.h"
+
+namespace gamzia
+{
+
+   struct WriteQueueStats
+   {
+      unsigned long long submitted;
+      unsigned long long committed;       // jobs whose work is durable
+      unsigned long long failed;          // jobs rolled back
+      unsigned long long groups;          // transactions (fsyncs)
+      size_t largestGroup;
+      size_t pending;                     // queued, not yet started
+   };
+
+   class WriteQueue
+   {
+
+   public:
+      typedef std::function<bool(Sqlite&)> Job;
+
+      WriteQueue(std::string dbname, size_t maxGroup = MAX_GROUP,
+         std::chrono::microseconds window = std::chrono::microseconds(WINDOW));
+      WriteQueue(ConnectionPool& pool, size_t maxGroup = MAX_GROUP,
+         std::chrono::microseconds window = std::chrono::microseconds(WINDOW));
+      ~WriteQueue();
+      WriteQueue(const WriteQueue&) = delete;
+      WriteQueue& operator=(const WriteQueue&) = delete;
+
+      bool isReady();
+      std::string getLastError();
+      std::future<bool> submit(Job job);
+      void stop();
+      WriteQueueStats getStats();
+
+      inline static const size_t MAX_GROUP = 1000;
+      inline static const long long WINDOW = 0;
+      inline static const std::string TESTDB = "testwq.db";
+
+   private:
+      struct Entry
+      {
+         Job job;
+         std::promise<bool> done;
+      };
+
+      std::unique_ptr<Sqlite> mydb;
+      ConnectionPool *mypool;
+      size_t mymaxgroup;
+      std::chrono::microseconds mywindow;
+      bool isReadyFlag;
+      std::string myerror;
+
+      std::mutex mylock;
+      std::condition_variable mywork;
+      std::deque<Entry> myqueue;
+      bool isStopping;
+      WriteQueueStats mystats;
+      std::thread mywriter;
+
+      void start();
+      void run();
+      void commitGroup(std::vector<Entry>& group);
+      bool runJob(sqlite3* handle, Sqlite& db, Entry& entry, bool& ok);
+      void finish(std::vector<Entry>& group, std::vector<bool>& results, size_t transactions);
+   }; // class
+
+}; // namespace
+
+bool doWQUnitTests();